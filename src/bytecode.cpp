@@ -0,0 +1,242 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "bytecode.h"
+#include <algorithm>
+#include <cmath>
+#include <libqalculate/Function.h>
+#include <libqalculate/Variable.h>
+#include <numbers>
+using namespace std;
+
+namespace {
+const size_t MAX_REGISTERS = 256;  // Bounds the workspace of a block
+
+struct Function
+{
+    const char *name;
+    double (*f)(double);
+};
+
+const Function functions[] = {
+    {"sin",  [](double x){ return sin(x); }},
+    {"cos",  [](double x){ return cos(x); }},
+    {"tan",  [](double x){ return tan(x); }},
+    {"asin", [](double x){ return asin(x); }},
+    {"acos", [](double x){ return acos(x); }},
+    {"atan", [](double x){ return atan(x); }},
+    {"sinh", [](double x){ return sinh(x); }},
+    {"cosh", [](double x){ return cosh(x); }},
+    {"tanh", [](double x){ return tanh(x); }},
+    {"exp",  [](double x){ return exp(x); }},
+    {"ln",   [](double x){ return log(x); }},
+    {"sqrt", [](double x){ return sqrt(x); }},
+    {"cbrt", [](double x){ return cbrt(x); }},
+    {"abs",  [](double x){ return fabs(x); }},
+};
+const uint8_t TRIGONOMETRIC_END = 3;  // sin, cos, tan take angles
+const uint8_t INVERSE_END = 6;        // asin, acos, atan return angles
+
+double angleFactor(AngleUnit unit)
+{
+    switch (unit)
+    {
+    case ANGLE_UNIT_DEGREES:  return numbers::pi / 180;
+    case ANGLE_UNIT_GRADIANS: return numbers::pi / 200;
+    default:                  return 1;
+    }
+}
+}
+
+optional<uint16_t> Bytecode::constant(double value)
+{
+    for (const auto &[r, v] : constants)
+        if (v == value)
+            return r;
+    if (register_count >= MAX_REGISTERS)
+        return {};
+    constants.emplace_back(register_count, value);
+    return register_count++;
+}
+
+optional<uint16_t> Bytecode::emit(Op op, uint16_t a, uint16_t b, uint8_t function)
+{
+    if (register_count >= MAX_REGISTERS)
+        return {};
+    code.push_back({op, function, register_count, a, b});
+    return register_count++;
+}
+
+optional<uint16_t> Bytecode::emit(const MathStructure &m)
+{
+    auto nary = [&](Op op) -> optional<uint16_t> {
+        if (m.size() == 0)
+            return {};
+        auto r = emit(m[0]);
+        for (size_t i = 1; r && i < m.size(); ++i)
+            if (auto b = emit(m[i]); b)
+                r = emit(op, *r, *b);
+            else
+                return {};
+        return r;
+    };
+
+    switch (m.type())
+    {
+    case STRUCT_NUMBER:
+        if (m.number().isComplex())
+            return {};
+        return constant(m.number().floatValue());
+
+    case STRUCT_SYMBOLIC:
+    case STRUCT_VARIABLE:
+    {
+        if (m.isVariable() && m.variable()->isKnown())
+        {
+            const auto &v = static_cast<KnownVariable*>(m.variable())->get();
+            if (!v.isNumber() || v.number().isComplex())
+                return {};
+            return constant(v.number().floatValue());
+        }
+        const auto &name = m.isVariable() ? m.variable()->referenceName() : m.symbol();
+        if (auto it = ranges::find(*names, name); it != names->end())
+            return uint16_t(it - names->begin());
+        return {};
+    }
+
+    case STRUCT_ADDITION:
+        return nary(Op::Add);
+
+    case STRUCT_MULTIPLICATION:
+        return nary(Op::Multiply);
+
+    case STRUCT_DIVISION:
+        if (m.size() == 2)
+            if (auto a = emit(m[0]); a)
+                if (auto b = emit(m[1]); b)
+                    return emit(Op::Divide, *a, *b);
+        return {};
+
+    case STRUCT_INVERSE:
+        if (m.size() == 1)
+            if (auto one = constant(1); one)
+                if (auto a = emit(m[0]); a)
+                    return emit(Op::Divide, *one, *a);
+        return {};
+
+    case STRUCT_NEGATE:
+        if (m.size() == 1)
+            if (auto a = emit(m[0]); a)
+                return emit(Op::Negate, *a);
+        return {};
+
+    case STRUCT_POWER:
+        if (m.size() != 2)
+            return {};
+        if (auto a = emit(m[0]); !a)
+            return {};
+        else if (m[1].isNumber() && m[1].number().isTwo())
+            return emit(Op::Square, *a);
+        else if (auto b = emit(m[1]); b)
+            return emit(Op::Power, *a, *b);
+        return {};
+
+    case STRUCT_FUNCTION:
+    {
+        const auto &name = m.function()->referenceName();
+        auto it = ranges::find(functions, name, &Function::name);
+        if (it == ranges::end(functions) || m.size() != 1)
+            return {};
+        const auto f = uint8_t(it - ranges::begin(functions));
+
+        auto a = emit(m[0]);
+        if (a && f < TRIGONOMETRIC_END && angle_factor != 1)
+            if (auto c = constant(angle_factor); c)
+                a = emit(Op::Multiply, *a, *c);
+        if (a)
+            a = emit(Op::Call, *a, 0, f);
+        if (a && f >= TRIGONOMETRIC_END && f < INVERSE_END && angle_factor != 1)
+            if (auto c = constant(1 / angle_factor); c)
+                a = emit(Op::Multiply, *a, *c);
+        return a;
+    }
+
+    default:
+        return {};
+    }
+}
+
+optional<Bytecode> Bytecode::compile(const MathStructure &parsed, const vector<string> &variables,
+                                     AngleUnit angle_unit)
+{
+    if (variables.size() > MAX_REGISTERS)
+        return {};
+
+    Bytecode bc;
+    bc.names = &variables;
+    bc.angle_factor = angleFactor(angle_unit);
+    bc.variable_count = bc.register_count = (uint16_t)variables.size();
+
+    // Constants and temporaries share the registers after the variables
+    auto result = bc.emit(parsed);
+    bc.names = nullptr;
+    if (!result)
+        return {};
+
+    bc.result = *result;
+    return bc;
+}
+
+void Bytecode::evaluate(const double *const *args, size_t n, double *out,
+                        vector<double> &workspace) const
+{
+    n = min(n, BLOCK);
+
+    // Constant columns are never written, fill them once per workspace
+    if (workspace.size() != register_count * BLOCK)
+    {
+        workspace.assign(register_count * BLOCK, 0);
+        for (const auto &[i, v] : constants)
+            fill_n(workspace.data() + i * BLOCK, BLOCK, v);
+    }
+
+    auto column = [&](uint16_t i){ return workspace.data() + i * BLOCK; };
+
+    for (uint16_t v = 0; v < variable_count; ++v)
+        copy_n(args[v], n, column(v));
+
+    for (const auto &in : code)
+    {
+        double *__restrict d = column(in.dst);
+        const double *__restrict a = column(in.a);
+        const double *__restrict b = column(in.b);
+        switch (in.op)
+        {
+        case Op::Add:
+            for (size_t i = 0; i < n; ++i) d[i] = a[i] + b[i];
+            break;
+        case Op::Multiply:
+            for (size_t i = 0; i < n; ++i) d[i] = a[i] * b[i];
+            break;
+        case Op::Divide:
+            for (size_t i = 0; i < n; ++i) d[i] = a[i] / b[i];
+            break;
+        case Op::Power:
+            for (size_t i = 0; i < n; ++i) d[i] = pow(a[i], b[i]);
+            break;
+        case Op::Square:
+            for (size_t i = 0; i < n; ++i) d[i] = a[i] * a[i];
+            break;
+        case Op::Negate:
+            for (size_t i = 0; i < n; ++i) d[i] = -a[i];
+            break;
+        case Op::Call:
+        {
+            const auto f = functions[in.function].f;
+            for (size_t i = 0; i < n; ++i) d[i] = f(a[i]);
+            break;
+        }
+        }
+    }
+
+    copy_n(column(result), n, out);
+}
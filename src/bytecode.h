@@ -0,0 +1,66 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <cstdint>
+#include <libqalculate/MathStructure.h>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+///
+/// Register bytecode for numeric expressions evaluated in double precision.
+///
+/// A parsed structure is compiled once into a flat array of three-address instructions.
+/// Every intermediate value gets its own register, variables and deduplicated constants
+/// occupy the first registers and are never written. The interpreter is a single loop
+/// over the instructions on blocks of contiguous doubles, every instruction is a
+/// vectorizable loop. Meant for sampling, results printed to the user stay with the
+/// calculator.
+///
+/// Supports numbers, real constants, the variables, arithmetic, powers and the common
+/// elementary functions. Anything else fails to compile and is left to the calculator.
+///
+class Bytecode
+{
+public:
+
+    static constexpr size_t BLOCK = 256;  ///< Maximum points per block evaluation
+
+    /// Returns nothing if the structure contains unsupported operations.
+    static std::optional<Bytecode> compile(const MathStructure &parsed,
+                                           const std::vector<std::string> &variables,
+                                           AngleUnit angle_unit);
+
+    /// Evaluates `n` points, `args[i]` points to `n` values of variable i. The workspace
+    /// is reused across calls.
+    void evaluate(const double *const *args, size_t n, double *out,
+                  std::vector<double> &workspace) const;
+
+private:
+
+    enum class Op : std::uint8_t { Add, Multiply, Divide, Power, Square, Negate, Call };
+
+    struct Instruction
+    {
+        Op op;
+        std::uint8_t function;
+        std::uint16_t dst;
+        std::uint16_t a;
+        std::uint16_t b;
+    };
+
+    std::optional<std::uint16_t> emit(const MathStructure &m);
+    std::optional<std::uint16_t> constant(double value);
+    std::optional<std::uint16_t> emit(Op op, std::uint16_t a, std::uint16_t b = 0,
+                                      std::uint8_t function = 0);
+
+    const std::vector<std::string> *names = nullptr;  // Only during compilation
+    double angle_factor = 1;
+    std::vector<Instruction> code;
+    std::vector<std::pair<std::uint16_t, double>> constants;  // Register and value
+    std::uint16_t variable_count = 0;
+    std::uint16_t register_count = 0;
+    std::uint16_t result = 0;
+
+};
@@ -0,0 +1,83 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "calculatorloader.h"
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <libqalculate/Calculator.h>
+#include <libqalculate/util.h>
+#include <vector>
+using namespace std;
+using namespace std::chrono;
+namespace fs = std::filesystem;
+
+namespace {
+
+template<typename F>
+milliseconds timed(F &&f)
+{
+    const auto start = steady_clock::now();
+    f();
+    return duration_cast<milliseconds>(steady_clock::now() - start);
+}
+
+vector<fs::path> definitionFiles(Calculator &qalc)
+{
+    vector<fs::path> files;
+
+    for (const auto &dir : { fs::path(getGlobalDefinitionsDir()),
+                             fs::path(buildPath(getLocalDataDir(), "definitions")) })
+    {
+        error_code ec;
+        for (const auto &entry : fs::directory_iterator(dir, ec))
+            if (entry.is_regular_file(ec) && entry.path().extension() == ".xml")
+                files.emplace_back(entry.path());
+    }
+
+    for (int i = 1; ; ++i)
+        if (auto file = qalc.getExchangeRatesFileName(i); file.empty())
+            break;
+        else
+            files.emplace_back(file);
+
+    return files;
+}
+
+// Reads the files concurrently so that the serialized parsing does not block on I/O
+void prefetch(const vector<fs::path> &files)
+{
+    vector<future<void>> futures;
+    futures.reserve(files.size());
+
+    for (const auto &file : files)
+        futures.emplace_back(async(launch::async, [&file]{
+            ifstream in(file, ios::binary);
+            char buffer[1 << 16];
+            while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0);
+        }));
+
+    for (auto &f : futures)
+        f.wait();
+}
+
+}
+
+milliseconds CalculatorLoader::Timings::total() const
+{ return prefetch + exchange_rates + currencies + global_definitions + local_definitions; }
+
+unique_ptr<Calculator> CalculatorLoader::load(Timings *timings)
+{
+    Timings t;
+    auto qalc = make_unique<Calculator>();
+
+    t.prefetch = timed([&]{ prefetch(definitionFiles(*qalc)); });
+    t.exchange_rates = timed([&]{ qalc->loadExchangeRates(); });
+    t.currencies = timed([&]{ qalc->loadGlobalCurrencies(); });
+    t.global_definitions = timed([&]{ qalc->loadGlobalDefinitions(); });
+    t.local_definitions = timed([&]{ qalc->loadLocalDefinitions(); });
+
+    if (timings)
+        *timings = t;
+
+    return qalc;
+}
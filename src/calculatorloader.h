@@ -0,0 +1,31 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <chrono>
+#include <memory>
+class Calculator;
+
+///
+/// Creates a Calculator and loads the standard definition sets.
+///
+/// The definition files are read concurrently up front. libqalculate parses and
+/// merges the files into the Calculator itself, which happens serialized afterwards
+/// and then reads from the page cache only.
+///
+class CalculatorLoader
+{
+public:
+
+    struct Timings
+    {
+        std::chrono::milliseconds prefetch{0};
+        std::chrono::milliseconds exchange_rates{0};
+        std::chrono::milliseconds currencies{0};
+        std::chrono::milliseconds global_definitions{0};
+        std::chrono::milliseconds local_definitions{0};
+        std::chrono::milliseconds total() const;
+    };
+
+    static std::unique_ptr<Calculator> load(Timings *timings = nullptr);
+
+};
@@ -0,0 +1,54 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "calculatortemplate.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <libqalculate/Calculator.h>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+using namespace std;
+
+CalculatorTemplate::CalculatorTemplate() : qalc(CalculatorLoader::load(&timings)) {}
+
+CalculatorTemplate::~CalculatorTemplate() = default;
+
+const CalculatorLoader::Timings &CalculatorTemplate::loadTimings() const { return timings; }
+
+pid_t CalculatorTemplate::fork(const function<void(Calculator&)> &work)
+{
+    fflush(nullptr);  // Do not duplicate pending output
+
+    const pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        work(*qalc);
+        _exit(EXIT_SUCCESS);
+    }
+    return pid;
+}
+
+CalculatorTemplate::MemoryUsage CalculatorTemplate::memoryUsage(pid_t pid)
+{
+    MemoryUsage usage;
+    ifstream in("/proc/" + to_string(pid) + "/smaps_rollup");
+
+    string line, key;
+    size_t kb;
+    while (getline(in, line))
+    {
+        if (!(istringstream(line) >> key >> kb))
+            continue;  // header
+        else if (key == "Rss:")
+            usage.rss_kb = kb;
+        else if (key == "Pss:")
+            usage.pss_kb = kb;
+        else if (key == "Shared_Clean:" || key == "Shared_Dirty:")
+            usage.shared_kb += kb;
+        else if (key == "Private_Clean:" || key == "Private_Dirty:")
+            usage.private_kb += kb;
+    }
+
+    return usage;
+}
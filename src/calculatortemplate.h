@@ -0,0 +1,47 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include "calculatorloader.h"
+#include <functional>
+#include <memory>
+#include <sys/types.h>
+
+///
+/// A loaded Calculator serving as template for worker processes.
+///
+/// libqalculate supports a single Calculator per process and has no way to copy one.
+/// Workers are therefore forked from a process holding the fully loaded template, they
+/// start in milliseconds and share the definitions copy-on-write. The template must not
+/// evaluate anything before forking, evaluation starts libqalculate threads which do not
+/// survive a fork.
+///
+class CalculatorTemplate
+{
+public:
+
+    CalculatorTemplate();
+    ~CalculatorTemplate();
+
+    const CalculatorLoader::Timings &loadTimings() const;
+
+    /// Forks a worker that runs `work` on the template calculator and exits.
+    /// Returns the pid of the worker or -1 on failure.
+    pid_t fork(const std::function<void(Calculator&)> &work);
+
+    struct MemoryUsage
+    {
+        size_t rss_kb = 0;      // resident
+        size_t pss_kb = 0;      // proportional share of shared pages
+        size_t shared_kb = 0;   // resident pages shared with other processes
+        size_t private_kb = 0;  // resident pages owned exclusively
+    };
+
+    /// Reads the memory usage of `pid` from /proc.
+    static MemoryUsage memoryUsage(pid_t pid);
+
+private:
+
+    std::unique_ptr<Calculator> qalc;
+    CalculatorLoader::Timings timings;
+
+};
@@ -0,0 +1,93 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "conversion.h"
+#include <cctype>
+#include <string_view>
+using namespace std;
+
+namespace {
+const string_view special = "+-*/^%()[]{}<>=!&|,;:\"'\\~";
+const string_view arrows[] = {"->", "\xe2\x86\x92"};  // "→"
+
+void skipSpaces(string_view &s)
+{
+    while (!s.empty() && isspace((unsigned char)s.front()))
+        s.remove_prefix(1);
+}
+
+bool readValue(string_view &s, string &value)
+{
+    size_t i = (!s.empty() && s.front() == '-') ? 1 : 0;
+    size_t digits = 0, dots = 0;
+    for (; i < s.size(); ++i)
+        if (isdigit((unsigned char)s[i]))
+            ++digits;
+        else if (s[i] == '.' && dots == 0)
+            ++dots;
+        else
+            break;
+    if (digits == 0)
+        return false;
+    value = s.substr(0, i);
+    s.remove_prefix(i);
+    return true;
+}
+
+bool readName(string_view &s, string &name)
+{
+    size_t i = 0;
+    for (; i < s.size(); ++i)
+    {
+        const auto c = (unsigned char)s[i];
+        if (isspace(c) || special.find((char)c) != string_view::npos || s.substr(i, 3) == arrows[1])
+            break;
+        if (isdigit(c) || c == '.')
+            return false;
+    }
+    if (i == 0)
+        return false;
+    name = s.substr(0, i);
+    s.remove_prefix(i);
+    return true;
+}
+
+bool readKeyword(string_view &s)
+{
+    for (const auto &a : arrows)
+        if (s.starts_with(a))
+        {
+            s.remove_prefix(a.size());
+            return true;
+        }
+    if (s.starts_with("to") && s.size() > 2 && isspace((unsigned char)s[2]))
+    {
+        s.remove_prefix(2);
+        return true;
+    }
+    return false;
+}
+}
+
+optional<Conversion> Conversion::parse(const string &expression)
+{
+    Conversion c;
+    string_view s(expression);
+
+    skipSpaces(s);
+    if (!readValue(s, c.value))
+        return {};
+    skipSpaces(s);
+    if (!readName(s, c.from))
+        return {};
+    skipSpaces(s);
+    if (!readKeyword(s))
+        return {};
+    skipSpaces(s);
+    if (!readName(s, c.to))
+        return {};
+    skipSpaces(s);
+    if (!s.empty())
+        return {};
+
+    return c;
+}
@@ -0,0 +1,21 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <optional>
+#include <string>
+
+///
+/// A plain conversion expression of the form "value name to name".
+///
+/// Accepts an optionally signed decimal value and names without digits, operators or
+/// brackets. Anything else is left to the full evaluation.
+///
+struct Conversion
+{
+    std::string value;
+    std::string from;
+    std::string to;
+
+    /// Expects an unlocalized expression.
+    static std::optional<Conversion> parse(const std::string &expression);
+};
@@ -0,0 +1,79 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "diagnostics.h"
+#include <cstring>
+#include <libqalculate/Calculator.h>
+using namespace Qt::StringLiterals;
+using namespace std;
+
+Diagnostics Diagnostics::collect(Calculator &qalc)
+{
+    Diagnostics d;
+    for (auto msg = qalc.message(); msg; msg = qalc.nextMessage())
+        d.add(msg->type(), msg->c_message());
+    return d;
+}
+
+void Diagnostics::add(MessageType severity, const char *text)
+{
+    // Truncate at a UTF-8 character boundary
+    string_view t(text);
+    const bool truncated = t.size() > text_capacity;
+    if (truncated)
+    {
+        auto n = text_capacity;
+        while (n > 0 && (t[n] & 0xC0) == 0x80)
+            --n;
+        t = t.substr(0, n);
+    }
+
+    for (size_t i = 0; i < size_; ++i)
+        if (messages[i].severity == severity && messages[i].text() == t)
+        {
+            ++messages[i].count;
+            return;
+        }
+
+    if (size_ < capacity)
+    {
+        auto &m = messages[size_++];
+        m.severity = severity;
+        m.count = 1;
+        m.length = (uint8_t)t.size();
+        m.truncated = truncated;
+        memcpy(m.buffer, t.data(), t.size());
+    }
+    else
+        ++dropped_;
+}
+
+MessageType Diagnostics::maxSeverity() const
+{
+    auto s = MESSAGE_INFORMATION;
+    for (size_t i = 0; i < size_; ++i)
+        s = max(s, messages[i].severity);
+    return s;
+}
+
+QString Diagnostics::text() const
+{
+    QString t;
+    for (auto severity : {MESSAGE_ERROR, MESSAGE_WARNING, MESSAGE_INFORMATION})
+        for (size_t i = 0; i < size_; ++i)
+        {
+            const auto &m = messages[i];
+            if (m.severity != severity)
+                continue;
+            if (!t.isEmpty())
+                t += u", "_s;
+            const auto text = m.text();
+            t += QString::fromUtf8(text.data(), (qsizetype)text.size());
+            if (m.truncated)
+                t += u"…"_s;
+            if (m.count > 1)
+                t += u" (×%1)"_s.arg(m.count);
+        }
+    if (dropped_)
+        t += u", … (+%1)"_s.arg(dropped_);
+    return t;
+}
@@ -0,0 +1,54 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <QString>
+#include <array>
+#include <cstdint>
+#include <libqalculate/includes.h>
+#include <string_view>
+class Calculator;
+
+///
+/// Messages of an evaluation.
+///
+/// Keeps at most `capacity` distinct messages with their severity and number of
+/// occurrences. Further messages are counted only. Message texts are stored inline and
+/// truncated to `text_capacity` bytes, so collecting and copying does not allocate. The
+/// display text is built on demand.
+///
+class Diagnostics
+{
+public:
+
+    static constexpr size_t capacity = 8;
+    static constexpr size_t text_capacity = 118;  // Messages of 128 bytes
+
+    struct Message
+    {
+        MessageType severity;
+        unsigned count;
+        std::uint8_t length;
+        bool truncated;
+        char buffer[text_capacity];
+
+        std::string_view text() const { return {buffer, length}; }
+    };
+
+    /// Drains the message queue of `qalc`.
+    static Diagnostics collect(Calculator &qalc);
+
+    bool empty() const { return size_ == 0; }
+    MessageType maxSeverity() const;
+
+    /// Joins the messages, errors first.
+    QString text() const;
+
+private:
+
+    void add(MessageType severity, const char *text);
+
+    std::array<Message, capacity> messages;
+    size_t size_ = 0;
+    size_t dropped_ = 0;
+
+};
@@ -0,0 +1,101 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "exchangerates.h"
+#include "lowercase.h"
+#include <algorithm>
+#include <libqalculate/Calculator.h>
+#include <libqalculate/Unit.h>
+using namespace std;
+
+shared_ptr<const ExchangeRates> ExchangeRates::make(Calculator &calculator,
+                                                     const EvaluationOptions &eo)
+{
+    auto table = make_shared<ExchangeRates>();
+    table->date_ = calculator.getExchangeRatesTime();
+
+    auto exact = eo;
+    exact.approximation = APPROXIMATION_EXACT;
+
+    for (auto *u : calculator.units)
+    {
+        if (!u->isActive() || !u->isCurrency() || u->baseUnit() != calculator.u_euro)
+            continue;
+
+        Number rate(1, 1);
+        if (u != calculator.u_euro)
+        {
+            MathStructure value(1, 1, 0), exponent(1, 1, 0);
+            u->convertToBaseUnit(value, exponent);
+            value.eval(exact);
+            if (!value.isNumber() || value.number().isZero())
+                continue;
+            rate = value.number();
+
+            // The full evaluation marks results of published rates approximate as well,
+            // which affects rounding and the subtext
+            if (u->isApproximate() || u->hasApproximateRelationTo(calculator.u_euro))
+                rate.setApproximate(true);
+        }
+
+        const auto index = (uint32_t)table->currencies.size();
+        table->currencies.push_back({u, rate});
+
+        for (size_t i = 1; i <= u->countNames(); ++i)  // One based
+        {
+            const auto &n = u->getName(i);
+            if (calculator.getActiveUnit(n.name) != u
+                || calculator.getActiveVariable(n.name) || calculator.getActiveFunction(n.name))
+                continue;
+            table->names.push_back({n.case_sensitive ? n.name : toLower(n.name),
+                                    index, n.case_sensitive});
+        }
+    }
+
+    ranges::sort(table->names, {}, &Name::key);
+    return table;
+}
+
+const ExchangeRates::Currency *ExchangeRates::find(const string &name) const
+{
+    auto lookup = [this](const string &key, bool case_sensitive) -> const Currency * {
+        auto [begin, end] = ranges::equal_range(names, key, {}, &Name::key);
+        for (auto it = begin; it != end; ++it)
+            if (it->case_sensitive == case_sensitive)
+                return &currencies[it->index];
+        return nullptr;
+    };
+
+    if (auto *c = lookup(name, true))
+        return c;
+    return lookup(toLower(name), false);
+}
+
+optional<MathStructure> ExchangeRates::convert(const Conversion &conversion) const
+{
+    const auto *from = find(conversion.from);
+    const auto *to = find(conversion.to);
+    if (!from || !to)
+        return {};
+
+    Number value(conversion.value);
+    if (!value.multiply(from->rate) || !value.divide(to->rate))
+        return {};
+    if (from->rate.isApproximate() || to->rate.isApproximate())
+        value.setApproximate(true);
+
+    MathStructure result(value);
+    result.multiply(MathStructure(to->unit));
+    return result;
+}
+
+time_t ExchangeRates::date() const { return date_; }
+
+bool ExchangeRates::containsCurrency(const MathStructure &m)
+{
+    if (m.isUnit())
+        return m.unit()->isCurrency();
+    for (size_t i = 0; i < m.size(); ++i)
+        if (containsCurrency(m[i]))
+            return true;
+    return false;
+}
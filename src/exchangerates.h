@@ -0,0 +1,65 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include "conversion.h"
+#include <cstdint>
+#include <ctime>
+#include <libqalculate/MathStructure.h>
+#include <libqalculate/Number.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+class Calculator;
+class Unit;
+struct EvaluationOptions;
+
+///
+/// Immutable snapshot of the loaded exchange rates.
+///
+/// Rates are kept in a flat array in euro per unit, names in a sorted array pointing into
+/// it. Simple conversions like "100 usd to eur" are answered by two lookups and two
+/// rational operations. Rates of approximate currencies are flagged approximate, so are
+/// the results using them. Only names resolving to the same currency in the calculator
+/// are indexed.
+///
+/// The snapshot references units of the calculator it was made from.
+///
+class ExchangeRates
+{
+public:
+
+    static std::shared_ptr<const ExchangeRates> make(Calculator &calculator,
+                                                     const EvaluationOptions &eo);
+
+    /// Returns nothing if the conversion is not between two known currencies.
+    std::optional<MathStructure> convert(const Conversion &conversion) const;
+
+    /// Time the rates were published.
+    std::time_t date() const;
+
+    /// Returns true if the structure contains any currency unit.
+    static bool containsCurrency(const MathStructure &mstruct);
+
+private:
+
+    struct Currency
+    {
+        Unit *unit;
+        Number rate;
+    };
+
+    struct Name
+    {
+        std::string key;  // Lower case unless case sensitive
+        std::uint32_t index;
+        bool case_sensitive;
+    };
+
+    const Currency *find(const std::string &name) const;
+
+    std::vector<Currency> currencies;
+    std::vector<Name> names;
+    std::time_t date_ = 0;
+
+};
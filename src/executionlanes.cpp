@@ -0,0 +1,78 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "executionlanes.h"
+#include <utility>
+using namespace std;
+
+ExecutionLanes::Ticket::Ticket(Ticket &&other) noexcept
+    : lanes(exchange(other.lanes, nullptr)) {}
+
+ExecutionLanes::Ticket &ExecutionLanes::Ticket::operator=(Ticket &&other) noexcept
+{
+    if (this != &other)
+    {
+        if (lanes)
+            lanes->release();
+        lanes = exchange(other.lanes, nullptr);
+    }
+    return *this;
+}
+
+ExecutionLanes::Ticket::~Ticket()
+{
+    if (lanes)
+        lanes->release();
+}
+
+ExecutionLanes::Ticket ExecutionLanes::acquire(Lane lane, const function<bool()> &isValid)
+{
+    unique_lock lock(mutex);
+
+    auto *waiting = lane == Lane::Triggered ? &triggered_waiting
+                  : lane == Lane::Global ? &global_waiting : nullptr;
+    if (waiting)
+        ++*waiting;
+
+    // Lower priority requests additionally wait for the higher priority queues to drain
+    auto blocked = [&]{ return busy || shouldYield(lane); };
+
+    while (blocked())
+    {
+        if (!isValid())
+        {
+            if (waiting)
+                --*waiting;
+            cv.notify_all();
+            return {};
+        }
+        cv.wait_for(lock, chrono::milliseconds(10));
+    }
+
+    if (waiting)
+        --*waiting;
+
+    busy = true;
+    return Ticket(this);
+}
+
+bool ExecutionLanes::shouldYield(Lane lane) const
+{
+    switch (lane) {
+    case Lane::Server:
+        return triggered_waiting > 0 || global_waiting > 0;
+    case Lane::Global:
+        return triggered_waiting > 0;
+    case Lane::Triggered:
+        return false;
+    }
+    return false;
+}
+
+void ExecutionLanes::release()
+{
+    {
+        lock_guard lock(mutex);
+        busy = false;
+    }
+    cv.notify_all();
+}
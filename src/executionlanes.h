@@ -0,0 +1,58 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+///
+/// Schedules access to the calculator for the global and the triggered query handler and
+/// for socket clients.
+///
+/// libqalculate supports a single Calculator per process, hence the lanes share one
+/// instance. Each lane queues separately, waiting requests are served in the order
+/// triggered, global, server and running evaluations are asked to yield to waiting
+/// requests of a higher priority lane.
+///
+class ExecutionLanes
+{
+public:
+
+    enum class Lane { Server, Global, Triggered };
+
+    class Ticket
+    {
+    public:
+        Ticket() = default;
+        Ticket(Ticket &&other) noexcept;
+        Ticket &operator=(Ticket &&other) noexcept;
+        ~Ticket();
+
+        explicit operator bool() const { return lanes != nullptr; }
+
+    private:
+        friend class ExecutionLanes;
+        explicit Ticket(ExecutionLanes *l) : lanes(l) {}
+        ExecutionLanes *lanes = nullptr;
+    };
+
+    /// Blocks until `lane` may use the calculator. Returns an invalid ticket if `isValid`
+    /// returns false while waiting. The calculator is released when the ticket is destroyed.
+    Ticket acquire(Lane lane, const std::function<bool()> &isValid);
+
+    /// Returns true if the evaluation running on `lane` should be aborted in favor of
+    /// pending work on a higher priority lane.
+    bool shouldYield(Lane lane) const;
+
+private:
+
+    void release();
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool busy = false;
+    std::atomic<int> triggered_waiting = 0;
+    std::atomic<int> global_waiting = 0;
+
+};
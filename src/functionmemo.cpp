@@ -0,0 +1,199 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "functionmemo.h"
+#include <libqalculate/Calculator.h>
+#include <libqalculate/Function.h>
+using namespace std;
+
+namespace {
+
+class MemoizedFunction : public UserFunction
+{
+public:
+
+    MemoizedFunction(const UserFunction *original, FunctionMemo &m)
+        : UserFunction(original), memo(m) {}
+
+    int calculate(MathStructure &mstruct, const MathStructure &vargs,
+                  const EvaluationOptions &eo) override
+    {
+        // Arguments may arrive unevaluated
+        MathStructure args(vargs);
+        for (size_t i = 0; i < args.size(); ++i)
+            if (!args[i].isNumber())
+                args[i].eval(eo);
+
+        auto key = FunctionMemo::makeKey(this, args, eo);
+        if (!key)
+            return UserFunction::calculate(mstruct, args, eo);  // Evaluated already
+
+        if (auto cached = memo.get(*key); cached)
+        {
+            mstruct = *cached;
+            return 1;
+        }
+
+        const auto result = UserFunction::calculate(mstruct, args, eo);
+        if (result > 0)
+        {
+            mstruct.eval(eo);
+            if (!CALCULATOR->aborted())
+                memo.put(*key, mstruct);
+        }
+        return result;
+    }
+
+private:
+
+    FunctionMemo &memo;
+
+};
+
+}
+
+FunctionMemo::FunctionMemo(size_t c) : capacity(c) {}
+
+void FunctionMemo::setScope(Scope s, Calculator &calculator)
+{
+    lock_guard lock(mutex);
+    scope_ = s;
+    lru.clear();
+    index.clear();
+
+    if (s == Scope::Off)
+    {
+        for (auto &[original, copy] : wrappers)
+        {
+            copy->setActive(false);
+            original->setActive(true);
+        }
+        return;
+    }
+
+    // Copy the list, adding functions modifies it
+    const auto functions = calculator.functions;
+    for (auto *f : functions)
+    {
+        if (f->subtype() != SUBTYPE_USER_FUNCTION || !f->isLocal())
+            continue;
+
+        auto *original = static_cast<UserFunction*>(f);
+        if (dynamic_cast<MemoizedFunction*>(original))
+            continue;
+
+        if (auto it = wrappers.find(original); it != wrappers.end())
+        {
+            if (original->isActive())  // Reactivate a previous copy
+            {
+                original->setActive(false);
+                it->second->setActive(true);
+            }
+        }
+        else if (original->isActive())
+        {
+            auto *copy = new MemoizedFunction(original, *this);
+            original->setActive(false);
+            calculator.addFunction(copy, true, false);  // Takes ownership
+            wrappers.emplace(original, copy);
+        }
+    }
+}
+
+FunctionMemo::Scope FunctionMemo::scope() const
+{
+    lock_guard lock(mutex);
+    return scope_;
+}
+
+void FunctionMemo::beginEvaluation(uint64_t g)
+{
+    lock_guard lock(mutex);
+    if (scope_ == Scope::Evaluation || generation != g)
+    {
+        lru.clear();
+        index.clear();
+        generation = g;
+    }
+}
+
+void FunctionMemo::clear()
+{
+    lock_guard lock(mutex);
+    lru.clear();
+    index.clear();
+    wrappers.clear();
+    generation = 0;
+}
+
+optional<string> FunctionMemo::makeKey(const UserFunction *function, const MathStructure &args,
+                                       const EvaluationOptions &eo)
+{
+    static const auto po = []{
+        PrintOptions o;
+        o.number_fraction_format = FRACTION_FRACTIONAL;
+        return o;
+    }();
+
+    string key = function->referenceName();
+    key += '\0';
+    key += to_string(CALCULATOR->getPrecision());
+    key += '\0';
+    key += to_string((int)eo.approximation);
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        const auto &a = args[i];
+        if (!a.isNumber() || !a.number().isRational() || a.number().isApproximate())
+            return {};
+        key += '\0';
+        key += a.number().print(po);
+    }
+    return key;
+}
+
+optional<MathStructure> FunctionMemo::get(const string &key)
+{
+    lock_guard lock(mutex);
+    if (auto it = index.find(key); it != index.end())
+    {
+        lru.splice(lru.begin(), lru, it->second);
+        ++hits_;
+        return it->second->result;
+    }
+    ++misses_;
+    return {};
+}
+
+void FunctionMemo::put(const string &key, const MathStructure &result)
+{
+    lock_guard lock(mutex);
+    if (scope_ == Scope::Off || index.contains(key))
+        return;
+
+    lru.emplace_front().key = key;
+    lru.front().result = result;
+    index.emplace(key, lru.begin());
+
+    if (lru.size() > capacity)
+    {
+        index.erase(lru.back().key);
+        lru.pop_back();
+    }
+}
+
+size_t FunctionMemo::hits() const
+{
+    lock_guard lock(mutex);
+    return hits_;
+}
+
+size_t FunctionMemo::misses() const
+{
+    lock_guard lock(mutex);
+    return misses_;
+}
+
+size_t FunctionMemo::size() const
+{
+    lock_guard lock(mutex);
+    return lru.size();
+}
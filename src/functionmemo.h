@@ -0,0 +1,75 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <cstdint>
+#include <libqalculate/MathStructure.h>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+class Calculator;
+class UserFunction;
+struct EvaluationOptions;
+
+///
+/// Memo table for user-defined functions.
+///
+/// When attached, every active local user function is replaced by a memoizing copy. Calls
+/// with exact rational arguments are looked up by function, arguments, precision and
+/// approximation mode before the formula is evaluated. Since recursive calls resolve to
+/// the copy as well, recursive definitions are evaluated once per distinct argument.
+///
+/// The table is bounded by the number of entries and evicts the least recently used. It
+/// is either reset for every evaluation or kept as long as the definitions generation.
+/// Functions are assumed to be pure, which is why memoization is opt-in.
+///
+class FunctionMemo
+{
+public:
+
+    enum class Scope { Off, Evaluation, Definitions };
+
+    explicit FunctionMemo(size_t capacity);
+
+    /// Wraps the user functions of the calculator if the scope is not Off, unwraps them
+    /// otherwise. Wraps functions added since the last call.
+    void setScope(Scope scope, Calculator &calculator);
+    Scope scope() const;
+
+    /// Resets the table per the scope.
+    void beginEvaluation(std::uint64_t generation);
+
+    /// Drops all references into the calculator.
+    void clear();
+
+    size_t hits() const;
+    size_t misses() const;
+    size_t size() const;
+
+    /// Returns the key of a call or nothing if the arguments are not exact rationals.
+    static std::optional<std::string> makeKey(const UserFunction *function,
+                                              const MathStructure &args,
+                                              const EvaluationOptions &eo);
+    std::optional<MathStructure> get(const std::string &key);
+    void put(const std::string &key, const MathStructure &result);
+
+private:
+
+    struct Entry
+    {
+        std::string key;
+        MathStructure result;
+    };
+
+    mutable std::mutex mutex;
+    const size_t capacity;
+    Scope scope_ = Scope::Off;
+    std::uint64_t generation = 0;
+    std::list<Entry> lru;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    std::unordered_map<UserFunction*, UserFunction*> wrappers;  // Original to copy
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+
+};
@@ -0,0 +1,16 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <algorithm>
+#include <string>
+
+///
+/// Folds ASCII letters to lower case, independent of the locale. Bytes of UTF-8
+/// sequences are kept, names compare case-sensitively beyond ASCII.
+///
+inline std::string toLower(std::string s)
+{
+    std::ranges::transform(s, s.begin(),
+                           [](char c){ return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c; });
+    return s;
+}
@@ -0,0 +1,141 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "nametrie.h"
+#include "lowercase.h"
+#include <algorithm>
+#include <libqalculate/Calculator.h>
+#include <numeric>
+#include <set>
+using namespace std;
+
+void NameTrie::clear()
+{
+    lock_guard lock(mutex);
+    entries.clear();
+    keys.clear();
+    nodes.clear();
+    generation = 0;
+}
+
+void NameTrie::update(uint64_t g, Calculator &calculator)
+{
+    lock_guard lock(mutex);
+    if (generation != g)
+        rebuild(g, calculator);
+}
+
+void NameTrie::rebuild(uint64_t g, Calculator &calculator)
+{
+    generation = g;
+
+    vector<Entry> unsorted;
+    set<pair<string, Kind>> seen;
+
+    auto add = [&](const string &name, const string &title, Kind kind) {
+        if (!name.empty() && seen.emplace(name, kind).second)
+            unsorted.push_back({name, title, kind});
+    };
+
+    auto addItem = [&](const ExpressionItem *item, Kind kind) {
+        if (!item->isActive() || item->isHidden())
+            return;
+        const auto title = item->title();
+        for (size_t i = 1; i <= item->countNames(); ++i)  // One based
+            add(item->getName(i).name, title, kind);
+    };
+
+    for (const auto *f : calculator.functions)
+        addItem(f, Kind::Function);
+    for (const auto *u : calculator.units)
+        addItem(u, Kind::Unit);
+    for (const auto *v : calculator.variables)
+        addItem(v, Kind::Variable);
+    for (const auto *p : calculator.prefixes)
+    {
+        add(p->longName(false), p->longName(), Kind::Prefix);
+        add(p->shortName(false), p->longName(), Kind::Prefix);
+    }
+
+    // Sort by lower case key
+    vector<string> unsorted_keys;
+    unsorted_keys.reserve(unsorted.size());
+    for (const auto &e : unsorted)
+        unsorted_keys.push_back(toLower(e.name));
+
+    vector<uint32_t> order(unsorted.size());
+    iota(order.begin(), order.end(), 0);
+    ranges::stable_sort(order, {}, [&](uint32_t i) -> const string & { return unsorted_keys[i]; });
+
+    entries.clear();
+    keys.clear();
+    entries.reserve(order.size());
+    keys.reserve(order.size());
+    for (auto i : order)
+    {
+        entries.push_back(std::move(unsorted[i]));
+        keys.push_back(std::move(unsorted_keys[i]));
+    }
+
+    // Breadth-first, children of a node are appended as one block
+    nodes.clear();
+    nodes.push_back({0, 0, 0, (uint32_t)keys.size(), 0});
+    vector<uint32_t> depth{0};
+    for (size_t n = 0; n < nodes.size(); ++n)
+    {
+        const auto d = depth[n];
+        auto b = nodes[n].begin;
+        const auto e = nodes[n].end;
+
+        while (b < e && keys[b].size() == d)  // Names ending here sort first
+            ++b;
+
+        nodes[n].children = (uint32_t)nodes.size();
+        while (b < e)
+        {
+            const auto byte = (unsigned char)keys[b][d];
+            auto c = b;
+            while (c < e && (unsigned char)keys[c][d] == byte)
+                ++c;
+            nodes.push_back({0, 0, b, c, byte});
+            depth.push_back(d + 1);
+            ++nodes[n].child_count;
+            b = c;
+        }
+    }
+    nodes.shrink_to_fit();
+}
+
+vector<NameTrie::Entry> NameTrie::complete(uint64_t g, Calculator &calculator,
+                                           const string &prefix, size_t max)
+{
+    lock_guard lock(mutex);
+
+    if (generation != g)
+        rebuild(g, calculator);
+
+    uint32_t n = 0;
+    for (unsigned char byte : toLower(prefix))
+    {
+        const auto *first = nodes.data() + nodes[n].children;
+        const auto *last = first + nodes[n].child_count;
+        const auto *it = lower_bound(first, last, byte,
+                                     [](const Node &node, unsigned char b){ return node.byte < b; });
+        if (it == last || it->byte != byte)
+            return {};
+        n = (uint32_t)(it - nodes.data());
+    }
+
+    vector<uint32_t> matches(nodes[n].end - nodes[n].begin);
+    iota(matches.begin(), matches.end(), nodes[n].begin);
+
+    const auto count = min(max, matches.size());
+    ranges::partial_sort(matches, matches.begin() + count, [this](uint32_t a, uint32_t b) {
+        return keys[a].size() != keys[b].size() ? keys[a].size() < keys[b].size() : a < b;
+    });
+
+    vector<Entry> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        result.push_back(entries[matches[i]]);
+    return result;
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+class Calculator;
+
+///
+/// Prefix trie over the names of all active functions, units, variables and prefixes.
+///
+/// Names are sorted case-insensitively, hence the names sharing a prefix form a contiguous
+/// range. The trie nodes live in a single array in breadth-first order, the children of a
+/// node are adjacent and sorted by byte. A lookup walks one node per byte and yields the
+/// range of matching names.
+///
+/// Building takes a few milliseconds, hence the owner calls update() after loading
+/// definitions rather than leaving it to the first completion.
+///
+class NameTrie
+{
+public:
+
+    enum class Kind : std::uint8_t { Function, Unit, Variable, Prefix };
+
+    struct Entry
+    {
+        std::string name;
+        std::string title;
+        Kind kind;
+    };
+
+    /// Rebuilds the trie unless it was built for the definitions `generation`.
+    void update(std::uint64_t generation, Calculator &calculator);
+
+    /// Returns up to `max` names starting with `prefix`, shortest first. Updates the trie
+    /// first.
+    std::vector<Entry> complete(std::uint64_t generation, Calculator &calculator,
+                                const std::string &prefix, size_t max);
+
+    void clear();
+
+private:
+
+    struct Node
+    {
+        std::uint32_t children;     // Index of the first child
+        std::uint32_t child_count;
+        std::uint32_t begin;        // Range of entries below this node
+        std::uint32_t end;
+        unsigned char byte;
+    };
+
+    void rebuild(std::uint64_t generation, Calculator &calculator);
+
+    std::mutex mutex;
+    std::uint64_t generation = 0;
+    std::vector<Entry> entries;
+    std::vector<std::string> keys;  // Lower case names, parallel to entries
+    std::vector<Node> nodes;
+
+};
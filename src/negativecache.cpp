@@ -0,0 +1,95 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "negativecache.h"
+#include <algorithm>
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+const auto base_backoff = seconds(5);
+const auto max_backoff = minutes(10);
+
+string makeKey(const char *profile, const string &expression)
+{
+    string key(profile);
+    key += '\0';
+    key += expression;
+    return key;
+}
+}
+
+NegativeCache::NegativeCache(size_t c) : capacity(c) {}
+
+NegativeCache::Failure NegativeCache::get(uint64_t g, const char *profile, const string &expression)
+{
+    lock_guard lock(mutex);
+    if (generation != g)
+        return {};
+
+    auto it = index.find(makeKey(profile, expression));
+    if (it == index.end())
+        return {};
+
+    lru.splice(lru.begin(), lru, it->second);
+    const auto &e = *it->second;
+
+    if (e.timeouts == 0)
+        return e.errors;
+    else if (clock::now() < e.retry_after)
+        return TimedOut{};
+    else
+        return {};  // Back-off expired, give it another try
+}
+
+NegativeCache::Entry &NegativeCache::upsert(uint64_t g, const char *profile, const string &expression)
+{
+    if (generation != g)
+    {
+        lru.clear();
+        index.clear();
+        generation = g;
+    }
+
+    auto key = makeKey(profile, expression);
+    if (auto it = index.find(key); it != index.end())
+    {
+        lru.splice(lru.begin(), lru, it->second);
+        return *it->second;
+    }
+
+    lru.emplace_front().key = key;
+    index.emplace(std::move(key), lru.begin());
+
+    if (lru.size() > capacity)
+    {
+        index.erase(lru.back().key);
+        lru.pop_back();
+    }
+
+    return lru.front();
+}
+
+void NegativeCache::putError(uint64_t g, const char *profile, const string &expression,
+                             const Diagnostics &errors)
+{
+    lock_guard lock(mutex);
+    auto &e = upsert(g, profile, expression);
+    e.errors = errors;
+    e.timeouts = 0;
+}
+
+void NegativeCache::putTimeout(uint64_t g, const char *profile, const string &expression)
+{
+    lock_guard lock(mutex);
+    auto &e = upsert(g, profile, expression);
+    const auto backoff = min<clock::duration>(base_backoff * (1 << min(e.timeouts, 16u)), max_backoff);
+    ++e.timeouts;
+    e.retry_after = clock::now() + backoff;
+}
+
+void NegativeCache::clear()
+{
+    lock_guard lock(mutex);
+    lru.clear();
+    index.clear();
+}
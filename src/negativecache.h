@@ -0,0 +1,60 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include "diagnostics.h"
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <variant>
+
+///
+/// Remembers expressions that failed to evaluate.
+///
+/// Errors are deterministic for a profile generation and are returned as is. Expressions
+/// exceeding the time budget are suppressed for a back-off period that doubles with every
+/// further timeout.
+///
+class NegativeCache
+{
+public:
+
+    struct TimedOut {};
+    using Failure = std::variant<std::monostate, Diagnostics, TimedOut>;
+
+    explicit NegativeCache(size_t capacity);
+
+    /// Returns std::monostate if the expression is not known to fail.
+    Failure get(std::uint64_t generation, const char *profile, const std::string &expression);
+
+    void putError(std::uint64_t generation, const char *profile,
+                  const std::string &expression, const Diagnostics &errors);
+
+    void putTimeout(std::uint64_t generation, const char *profile,
+                    const std::string &expression);
+
+    void clear();
+
+private:
+
+    using clock = std::chrono::steady_clock;
+
+    struct Entry
+    {
+        std::string key;
+        Diagnostics errors;
+        unsigned timeouts = 0;
+        clock::time_point retry_after;
+    };
+
+    Entry &upsert(std::uint64_t generation, const char *profile, const std::string &expression);
+
+    std::mutex mutex;
+    const size_t capacity;
+    std::uint64_t generation = 0;
+    std::list<Entry> lru;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+
+};
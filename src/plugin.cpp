@@ -1,14 +1,23 @@
 // Copyright (c) 2023-2025 Manuel Schneider
 
+#include "calculatorloader.h"
 #include "plugin.h"
+#include "sampler.h"
 #include "ui_configwidget.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
 #include <QSettings>
+#include <QStandardPaths>
 #include <QThread>
 #include <QtConcurrentRun>
 #include <albert/icon.h>
 #include <albert/logging.h>
 #include <albert/standarditem.h>
 #include <albert/systemutil.h>
+#include <cmath>
+#include <libqalculate/util.h>
 ALBERT_LOGGING_CATEGORY("qalculate")
 using namespace Qt::StringLiterals;
 using namespace albert;
@@ -22,12 +31,85 @@ const auto CFG_PARSINGMODE = "parsing_mode";
 const auto DEF_PARSINGMODE = (int)PARSING_MODE_CONVENTIONAL;
 const auto CFG_PRECISION   = u"precision"_s;
 const auto DEF_PRECISION   = 16;
+const auto CFG_GLOBAL_PRECISION = u"global_precision"_s;
 const auto CFG_UNITS       = u"units_in_global_query"_s;
 const auto DEF_UNITS       = false;
 const auto CFG_FUNCS       = u"functions_in_global_query"_s;
 const auto DEF_FUNCS       = false;
+const auto CFG_SERVER      = u"serve_local_socket"_s;
+const auto DEF_SERVER      = false;
+const auto CFG_RECORDING   = u"query_recording"_s;
+const auto DEF_RECORDING   = 0;  // Off
+const auto CFG_SLOWQUERY   = u"slow_query_threshold"_s;
+const auto DEF_SLOWQUERY   = 100;  // ms
+const auto SLOWEST_COUNT   = 10;
+const auto GLOBAL_BUDGET   = chrono::milliseconds(1000);
+const auto CFG_RECYCLE_QUERIES = u"recycle_after_queries"_s;
+const auto DEF_RECYCLE_QUERIES = 0;  // Never
+const auto CFG_RECYCLE_MEMORY  = u"recycle_above_mib"_s;
+const auto DEF_RECYCLE_MEMORY  = 0;  // Never
+const auto CFG_MEMOIZE         = u"memoize_user_functions"_s;
+const auto DEF_MEMOIZE         = (int)FunctionMemo::Scope::Off;
+const auto CFG_SIEVE_SIZE      = u"prime_sieve_mib"_s;
+const auto DEF_SIEVE_SIZE      = 8;
+const auto RECYCLE_IDLE_TIME   = chrono::seconds(3);
+const auto COMPLETION_COUNT    = 8;
+const auto REPRESENTATION_LENGTH = 64;  // characters of the result
+const auto SAMPLING_POINTS     = 4096;
+const auto SAMPLING_ROWS       = 6;
+const auto SPARKLINE_WIDTH     = 32;
+const QRegularExpression RE_SAMPLING(uR"(^(.+)\s+for\s+([A-Za-z_]\w*)\s+from\s+(.+)\s+to\s+(.+)$)"_s);
 
 static unique_ptr<Icon> makeIcon() { return Icon::theme(u"accessories-calculator"_s); }
+
+static chrono::microseconds elapsedSince(chrono::steady_clock::time_point start)
+{ return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start); }
+
+// Splits at newlines and at semicolons outside of brackets. Semicolons within brackets
+// separate matrix rows and function arguments.
+static QStringList splitExpressions(const QString &text)
+{
+    QStringList expressions;
+    qsizetype begin = 0;
+    int depth = 0;
+
+    auto append = [&](qsizetype end){
+        if (auto e = text.mid(begin, end - begin).trimmed(); !e.isEmpty())
+            expressions << e;
+        begin = end + 1;
+    };
+
+    for (qsizetype i = 0; i < text.size(); ++i)
+    {
+        const auto c = text[i];
+        if (c == u'(' || c == u'[' || c == u'{')
+            ++depth;
+        else if ((c == u')' || c == u']' || c == u'}') && depth > 0)
+            --depth;
+        else if (c == u'\n' || (c == u';' && depth == 0))
+            append(i);
+    }
+    append(text.size());
+
+    return expressions;
+}
+}
+
+Plugin::~Plugin()
+{
+    // Waits for running socket requests
+    server.reset();
+
+    // Background tasks use the calculator and the caches. Their continuations are
+    // dropped with this context object.
+    for (auto &future : background_tasks)
+        future.waitForFinished();
+}
+
+void Plugin::addBackgroundTask(const QFuture<void> &future)
+{
+    background_tasks.removeIf([](const auto &f){ return f.isFinished(); });
+    background_tasks << future;
 }
 
 void Plugin::initialize()
@@ -36,39 +118,305 @@ void Plugin::initialize()
     {
         auto s = settings();
 
+        // user configuration
+        config.angle_unit = static_cast<AngleUnit>(s->value(CFG_ANGLEUNIT, DEF_ANGLEUNIT).toInt());
+        config.parsing_mode = static_cast<ParsingMode>(s->value(CFG_PARSINGMODE, DEF_PARSINGMODE).toInt());
+        config.precision = s->value(CFG_PRECISION, DEF_PRECISION).toInt();
+        config.global_precision = s->value(CFG_GLOBAL_PRECISION,
+                                           min(config.precision, DEF_PRECISION)).toInt();
+        config.units_in_global_query = s->value(CFG_UNITS, DEF_UNITS).toBool();
+        config.functions_in_global_query = s->value(CFG_FUNCS, DEF_FUNCS).toBool();
+
+        stats = make_unique<QueryStats>(dataLocation() / "slow_queries.log");
+        stats->setThreshold(chrono::milliseconds(s->value(CFG_SLOWQUERY, DEF_SLOWQUERY).toInt()));
+
+        recycling.setMaxQueries(s->value(CFG_RECYCLE_QUERIES, DEF_RECYCLE_QUERIES).toUInt());
+        recycling.setMaxGrowthMiB(s->value(CFG_RECYCLE_MEMORY, DEF_RECYCLE_MEMORY).toUInt());
+
+        error_code ec;
+        filesystem::create_directories(cacheLocation(), ec);
+        const auto sieve_mib = s->value(CFG_SIEVE_SIZE, DEF_SIEVE_SIZE).toUInt();
+        sieve = make_unique<PrimeSieve>(cacheLocation() / "primes.bin", (size_t)sieve_mib << 20);
+
         // init calculator
-        qalc.reset(new Calculator());
-        qalc->loadExchangeRates();
-        qalc->loadGlobalCurrencies();
-        qalc->loadGlobalDefinitions();
-        qalc->loadLocalDefinitions();
-        qalc->setPrecision(s->value(CFG_PRECISION, DEF_PRECISION).toInt());
-
-        // evaluation options
-        eo.auto_post_conversion = POST_CONVERSION_BEST;
-        eo.structuring = STRUCTURING_SIMPLIFY;
-
-        // parse options
-        eo.parse_options.angle_unit = static_cast<AngleUnit>(s->value(CFG_ANGLEUNIT, DEF_ANGLEUNIT).toInt());
-        eo.parse_options.functions_enabled = s->value(CFG_FUNCS, DEF_FUNCS).toBool();
-        eo.parse_options.limit_implicit_multiplication = true;
-        eo.parse_options.parsing_mode = static_cast<ParsingMode>(s->value(CFG_PARSINGMODE, DEF_PARSINGMODE).toInt());
-        eo.parse_options.units_enabled = s->value(CFG_UNITS, DEF_UNITS).toBool();
-        eo.parse_options.unknowns_enabled = false;
-
-        // print options
-        po.indicate_infinite_series = true;
-        po.interval_display = INTERVAL_DISPLAY_SIGNIFICANT_DIGITS;
-        po.lower_case_e = true;
-        //po.preserve_precision = true;  // https://github.com/albertlauncher/plugins/issues/92
-        po.use_unicode_signs = true;
-        //po.abbreviate_names = true;
-    })
-    .then(this, [this] {
+        CalculatorLoader::Timings t;
+        qalc = CalculatorLoader::load(&t);
+        INFO << u"Calculator loaded in %1 ms (prefetch %2 ms, exchange rates %3 ms, "
+                "currencies %4 ms, global definitions %5 ms, local definitions %6 ms)"_s
+                .arg(t.total().count()).arg(t.prefetch.count()).arg(t.exchange_rates.count())
+                .arg(t.currencies.count()).arg(t.global_definitions.count())
+                .arg(t.local_definitions.count());
+        exchange_rates = ExchangeRates::make(*qalc, EvaluationOptions());
+        function_memo.setScope(
+            static_cast<FunctionMemo::Scope>(s->value(CFG_MEMOIZE, DEF_MEMOIZE).toInt()), *qalc);
+        updateIndexesLocked();
+        recycling.reset();
+
+        lock_guard lock(profiles_mutex);
+        profiles = Profiles::make(config);
+    });
+    addBackgroundTask(future);
+    future.then(this, [this] {
+        recycling_timer.setSingleShot(true);
+        recycling_timer.setInterval(RECYCLE_IDLE_TIME);
+        connect(&recycling_timer, &QTimer::timeout, this, [this]{
+            // Wait until the user is idle, loading takes a moment
+            const auto idle = chrono::steady_clock::now().time_since_epoch().count() - last_query;
+            if (chrono::steady_clock::duration(idle) < RECYCLE_IDLE_TIME)
+                recycling_timer.start();
+            else
+                recycleCalculator();
+        });
+
+        watchLocalDefinitions();
+        setServerEnabled(settings()->value(CFG_SERVER, DEF_SERVER).toBool());
+        setRecordingMode(settings()->value(CFG_RECORDING, DEF_RECORDING).toInt());
         emit initialized();
     });
 }
 
+void Plugin::scheduleRecycling()
+{
+    if (!recycling_scheduled.exchange(true))
+        QMetaObject::invokeMethod(&recycling_timer, qOverload<>(&QTimer::start), Qt::QueuedConnection);
+}
+
+void Plugin::recycleCalculator()
+{
+    auto future = QtConcurrent::run([this]
+    {
+        // Queued queries go first, queries arriving meanwhile wait for the fresh instance.
+        // One Calculator per process, the old one has to go before loading the new one.
+        auto ticket = lanes.acquire(ExecutionLanes::Lane::Server, []{ return true; });
+        INFO << "Replacing the calculator by a fresh instance";
+        const auto heap_before = RecyclingPolicy::heap();
+
+        // Cached structures reference definitions of the old instance
+        result_cache.clear();
+        term_cache.clear();
+        negative_cache.clear();
+        unit_graph.clear();
+        name_trie.clear();
+        spelling_index.clear();
+        exchange_rates.reset();
+        const auto memo_scope = function_memo.scope();
+        function_memo.clear();
+
+        qalc.reset();
+        const auto heap_released = RecyclingPolicy::heap();
+        qalc = CalculatorLoader::load();
+        exchange_rates = ExchangeRates::make(*qalc, EvaluationOptions());
+        function_memo.setScope(memo_scope, *qalc);
+        updateIndexesLocked();
+
+        const auto heap_after = RecyclingPolicy::heap();
+        INFO << u"Heap before replacing the calculator %1 MiB, without calculator %2 MiB, "
+                "after %3 MiB"_s.arg(heap_before.allocated >> 20)
+                .arg(heap_released.allocated >> 20).arg(heap_after.allocated >> 20);
+        if (!recycling.restart(heap_before, heap_after))
+            WARN << "Replacing the calculator did not return the memory, "
+                    "the memory limit is not applied anymore";
+
+        lock_guard lock(profiles_mutex);
+        profiles = Profiles::make(profiles->config);
+    });
+    addBackgroundTask(future);
+    future.then(this, [this] { recycling_scheduled = false; });
+}
+
+void Plugin::watchLocalDefinitions()
+{
+    const auto dir = QString::fromStdString(buildPath(getLocalDataDir(), "definitions"));
+    QDir().mkpath(dir);
+    definitions_watcher.addPath(dir);
+    for (const auto &fi : QDir(dir).entryInfoList({u"*.xml"_s}, QDir::Files))
+        definitions_watcher.addPath(fi.absoluteFilePath());
+
+    // Editors tend to write files in several steps, collect them before reloading
+    definitions_reload_timer.setSingleShot(true);
+    definitions_reload_timer.setInterval(500);
+
+    connect(&definitions_watcher, &QFileSystemWatcher::fileChanged, this, [this](const QString &path){
+        if (!changed_definitions.contains(path))
+            changed_definitions << path;
+        definitions_reload_timer.start();
+    });
+
+    connect(&definitions_watcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString &dir){
+        for (const auto &fi : QDir(dir).entryInfoList({u"*.xml"_s}, QDir::Files))
+            if (!definitions_watcher.files().contains(fi.absoluteFilePath())
+                && !changed_definitions.contains(fi.absoluteFilePath()))
+                changed_definitions << fi.absoluteFilePath();
+        definitions_reload_timer.start();
+    });
+
+    connect(&definitions_reload_timer, &QTimer::timeout, this, &Plugin::reloadLocalDefinitions);
+}
+
+void Plugin::reloadLocalDefinitions()
+{
+    auto files = std::exchange(changed_definitions, {});
+
+    // Replaced files drop out of the watcher
+    for (const auto &file : as_const(files))
+        if (QFile::exists(file) && !definitions_watcher.files().contains(file))
+            definitions_watcher.addPath(file);
+
+    auto future = QtConcurrent::run([this, files]
+    {
+        // Apply all files under one ticket, no evaluation sees a partial update
+        auto ticket = lanes.acquire(ExecutionLanes::Lane::Triggered, []{ return true; });
+        for (const auto &file : files)
+        {
+            if (!QFile::exists(file))
+                continue;  // Removed definitions stay active until the next restart
+            INFO << "Reloading definitions" << file;
+            if (qalc->loadDefinitions(file.toLocal8Bit().constData(), true, true) < 1)
+                WARN << "Failed loading definitions" << file;
+        }
+
+        // Memoize functions added by the files
+        function_memo.setScope(function_memo.scope(), *qalc);
+        updateIndexesLocked();
+
+        // A new profile generation invalidates derived caches. Published before the
+        // ticket is released, no query sees cached results of the old definitions.
+        lock_guard lock(profiles_mutex);
+        profiles = Profiles::make(profiles->config);
+    });
+    addBackgroundTask(future);
+}
+
+void Plugin::updateIndexesLocked()
+{
+    ++definitions_generation;
+    unit_graph.update(definitions_generation, *qalc);
+    name_trie.update(definitions_generation, *qalc);
+    spelling_index.update(definitions_generation, *qalc);
+}
+
+shared_ptr<const Profiles> Plugin::currentProfiles() const
+{
+    lock_guard lock(profiles_mutex);
+    return profiles;
+}
+
+void Plugin::updateConfig(const function<void(Config&)> &modify)
+{
+    modify(config);
+    // Background tasks may publish a new generation meanwhile
+    lock_guard lock(profiles_mutex);
+    profiles = Profiles::make(config, profiles.get());
+}
+
+void Plugin::setServerEnabled(bool enabled)
+{
+    if (!enabled)
+        server.reset();
+    else if (!server)
+    {
+        auto path = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+        server = make_unique<Server>(path + u"/albert-calculator.sock"_s,
+                                     [this](const auto &requests){ return serve(requests); });
+    }
+}
+
+void Plugin::setRecordingMode(int mode)
+{
+    // 0 is off, followed by the QueryRecorder modes
+    shared_ptr<QueryRecorder> r;
+    if (mode > 0)
+        r = make_shared<QueryRecorder>(dataLocation() / "queries.tsv",
+                                       static_cast<QueryRecorder::Mode>(mode - 1));
+    lock_guard lock(recorder_mutex);
+    recorder.swap(r);
+}
+
+void Plugin::setMemoizationScope(int scope)
+{
+    // Replaces functions of the calculator
+    auto future = QtConcurrent::run([this, scope]
+    {
+        auto ticket = lanes.acquire(ExecutionLanes::Lane::Triggered, []{ return true; });
+        function_memo.setScope(static_cast<FunctionMemo::Scope>(scope), *qalc);
+    });
+    addBackgroundTask(future);
+}
+
+void Plugin::setSieveSize(int mib)
+{
+    auto future = QtConcurrent::run([this, mib]
+    {
+        auto ticket = lanes.acquire(ExecutionLanes::Lane::Triggered, []{ return true; });
+        sieve.reset();  // Unmap before the file is resized
+        sieve = make_unique<PrimeSieve>(cacheLocation() / "primes.bin", (size_t)mib << 20);
+    });
+    addBackgroundTask(future);
+}
+
+vector<Server::Response> Plugin::serve(const vector<Server::Request> &requests)
+{
+    vector<Server::Response> responses;
+    responses.reserve(requests.size());
+
+    for (const auto &request : requests)
+    {
+        const auto deadline = request.deadline_ms
+            ? chrono::steady_clock::now() + chrono::milliseconds(request.deadline_ms)
+            : chrono::steady_clock::time_point::max();
+        auto isValid = [&]{ return !*request.cancelled && chrono::steady_clock::now() < deadline; };
+        responses.push_back({Server::Status::Aborted, false, {}});
+        auto &response = responses.back();
+
+        // Served on the server lane, i.e. launcher queries of both handlers take precedence,
+        // unless the client asks for the lane of the launcher handler, e.g. for replays.
+        // Preempted evaluations are retried until the deadline passes. Requests without
+        // a deadline get the budget of the global query handler.
+        const auto lane = !request.launcher ? ExecutionLanes::Lane::Server
+                          : request.global  ? ExecutionLanes::Lane::Global
+                                            : ExecutionLanes::Lane::Triggered;
+        const auto budget = request.deadline_ms ? chrono::milliseconds{} : GLOBAL_BUDGET;
+        chrono::microseconds calculate{0};
+        while (isValid())
+        {
+            auto ticket = lanes.acquire(lane, isValid);
+            if (!ticket)
+                break;
+
+            // Definitions may have been reloaded while waiting
+            const auto p = currentProfiles();
+            const auto &profile = request.global ? p->global : p->triggered;
+            auto e = evaluateLocked(request.expression.trimmed(), *p, profile, lane, isValid,
+                                    budget);
+            calculate += e.sample.calculate;
+
+            const auto start = chrono::steady_clock::now();
+            if (holds_alternative<monostate>(e.result))
+            {
+                stats->add(e.sample);
+                if (e.sample.cached)
+                    break;  // Backing off
+                continue;
+            }
+            else if (auto *mstruct = get_if<MathStructure>(&e.result))
+            {
+                mstruct->format(p->po);
+                response = {Server::Status::Ok, e.sample.cached,
+                            QString::fromStdString(mstruct->print(p->po))};
+            }
+            else
+                response = {Server::Status::Error, e.sample.cached,
+                            get<Diagnostics>(e.result).text()};
+            e.sample.print = elapsedSince(start);
+            stats->add(e.sample);
+            break;
+        }
+        response.calculate = calculate;
+    }
+
+    return responses;
+}
+
 QString Plugin::defaultTrigger() const { return u"="_s; }
 
 QString Plugin::synopsis(const QString &) const
@@ -84,62 +432,160 @@ QWidget *Plugin::buildConfigWidget()
     ui.setupUi(widget);
 
     // Angle unit
-    ui.angleUnitComboBox->setCurrentIndex(eo.parse_options.angle_unit);
+    ui.angleUnitComboBox->setCurrentIndex(config.angle_unit);
     connect(ui.angleUnitComboBox,
             static_cast<void(QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
             this, [this](int index){
         settings()->setValue(CFG_ANGLEUNIT, index);
-        lock_guard locker(qalculate_mutex);
-        eo.parse_options.angle_unit = static_cast<AngleUnit>(index);
+        updateConfig([=](Config &c){ c.angle_unit = static_cast<AngleUnit>(index); });
     });
 
     // Parsing mode
-    ui.parsingModeComboBox->setCurrentIndex(eo.parse_options.parsing_mode);
+    ui.parsingModeComboBox->setCurrentIndex(config.parsing_mode);
     connect(ui.parsingModeComboBox,
             static_cast<void(QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
             this, [this](int index){
         settings()->setValue(CFG_PARSINGMODE, index);
-        lock_guard locker(qalculate_mutex);
-        eo.parse_options.parsing_mode = static_cast<ParsingMode>(index);
+        updateConfig([=](Config &c){ c.parsing_mode = static_cast<ParsingMode>(index); });
     });
 
     // Precision
-    ui.precisionSpinBox->setValue(qalc->getPrecision());
+    ui.precisionSpinBox->setValue(config.precision);
     connect(ui.precisionSpinBox,
             static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
             this, [this](int value){
         settings()->setValue(CFG_PRECISION, value);
-        lock_guard locker(qalculate_mutex);
-        qalc->setPrecision(value);
+        updateConfig([=](Config &c){ c.precision = value; });
+    });
+
+    // Global precision
+    ui.globalPrecisionSpinBox->setValue(config.global_precision);
+    connect(ui.globalPrecisionSpinBox,
+            static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this, [this](int value){
+        settings()->setValue(CFG_GLOBAL_PRECISION, value);
+        updateConfig([=](Config &c){ c.global_precision = value; });
     });
 
     // Units in global query
-    ui.unitsInGlobalQueryCheckBox->setChecked(eo.parse_options.units_enabled);
+    ui.unitsInGlobalQueryCheckBox->setChecked(config.units_in_global_query);
     connect(ui.unitsInGlobalQueryCheckBox, &QCheckBox::toggled, this, [this](bool checked)
     {
         settings()->setValue(CFG_UNITS, checked);
-        lock_guard locker(qalculate_mutex);
-        eo.parse_options.units_enabled = checked;
+        updateConfig([=](Config &c){ c.units_in_global_query = checked; });
     });
 
     // Functions in global query
-    ui.functionsInGlobalQueryCheckBox->setChecked(eo.parse_options.functions_enabled);
+    ui.functionsInGlobalQueryCheckBox->setChecked(config.functions_in_global_query);
     connect(ui.functionsInGlobalQueryCheckBox, &QCheckBox::toggled, this, [this](bool checked)
     {
         settings()->setValue(CFG_FUNCS, checked);
-        lock_guard locker(qalculate_mutex);
-        eo.parse_options.functions_enabled = checked;
+        updateConfig([=](Config &c){ c.functions_in_global_query = checked; });
+    });
+
+    // Local socket server
+    ui.serverCheckBox->setChecked(server != nullptr);
+    connect(ui.serverCheckBox, &QCheckBox::toggled, this, [this](bool checked)
+    {
+        settings()->setValue(CFG_SERVER, checked);
+        setServerEnabled(checked);
+    });
+
+    // Query recording
+    ui.recordingComboBox->setCurrentIndex(settings()->value(CFG_RECORDING, DEF_RECORDING).toInt());
+    connect(ui.recordingComboBox,
+            static_cast<void(QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+            this, [this](int index){
+        settings()->setValue(CFG_RECORDING, index);
+        setRecordingMode(index);
+    });
+
+    // Recycling
+    ui.recycleQueriesSpinBox->setValue(settings()->value(CFG_RECYCLE_QUERIES, DEF_RECYCLE_QUERIES).toInt());
+    connect(ui.recycleQueriesSpinBox,
+            static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this, [this](int value){
+        settings()->setValue(CFG_RECYCLE_QUERIES, value);
+        recycling.setMaxQueries(value);
+    });
+
+    ui.recycleMemorySpinBox->setValue(settings()->value(CFG_RECYCLE_MEMORY, DEF_RECYCLE_MEMORY).toInt());
+    connect(ui.recycleMemorySpinBox,
+            static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this, [this](int value){
+        settings()->setValue(CFG_RECYCLE_MEMORY, value);
+        recycling.setMaxGrowthMiB(value);
+    });
+
+    // Memoization
+    ui.memoizeComboBox->setCurrentIndex(settings()->value(CFG_MEMOIZE, DEF_MEMOIZE).toInt());
+    connect(ui.memoizeComboBox,
+            static_cast<void(QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+            this, [this](int index){
+        settings()->setValue(CFG_MEMOIZE, index);
+        setMemoizationScope(index);
+    });
+
+    ui.memoLabel->setText(tr("%1 hits, %2 misses, %3 entries")
+                          .arg(function_memo.hits())
+                          .arg(function_memo.misses())
+                          .arg(function_memo.size()));
+
+    // Prime sieve
+    ui.sieveSizeSpinBox->setValue(settings()->value(CFG_SIEVE_SIZE, DEF_SIEVE_SIZE).toInt());
+    connect(ui.sieveSizeSpinBox,
+            static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this, [this](int value){
+        settings()->setValue(CFG_SIEVE_SIZE, value);
+        setSieveSize(value);
     });
 
+    // Slow queries
+    ui.slowQueryThresholdSpinBox->setValue(stats->threshold().count());
+    connect(ui.slowQueryThresholdSpinBox,
+            static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this, [this](int value){
+        settings()->setValue(CFG_SLOWQUERY, value);
+        stats->setThreshold(chrono::milliseconds(value));
+    });
+
+    const auto [p50, p95, p99] = stats->percentiles();
+    ui.latencyLabel->setText(tr("p50 %1 ms, p95 %2 ms, p99 %3 ms (%n queries)", nullptr,
+                                (int)stats->count())
+                             .arg(p50.count() / 1000., 0, 'f', 1)
+                             .arg(p95.count() / 1000., 0, 'f', 1)
+                             .arg(p99.count() / 1000., 0, 'f', 1));
+
+    for (const auto &sample : stats->slowest(SLOWEST_COUNT))
+    {
+        auto *item = new QListWidgetItem(u"%1 ms  %2"_s
+                                         .arg(sample.total().count() / 1000., 0, 'f', 1)
+                                         .arg(sample.expression),
+                                         ui.slowQueriesListWidget);
+        item->setToolTip(tr("Profile: %1\nPrepare: %2 µs\nCalculate: %3 µs\nPrint: %4 µs%5")
+                         .arg(sample.profile)
+                         .arg(sample.prepare.count())
+                         .arg(sample.calculate.count())
+                         .arg(sample.print.count())
+                         .arg(sample.aborted ? tr("\nAborted") : QString()));
+    }
+
     return widget;
 }
 
-shared_ptr<Item> Plugin::buildItem(const QString &query, MathStructure &mstruct) const
+shared_ptr<Item> Plugin::buildItem(const QString &query, MathStructure &mstruct,
+                                   const PrintOptions &po) const
 {
     static const auto tr_tr = tr("Copy result to clipboard");
     static const auto tr_te = tr("Copy equation to clipboard");
     static const auto tr_e = tr("Result of %1");
     static const auto tr_a = tr("Approximate result of %1");
+    static const auto tr_r = tr("%1, exchange rates of %2");
+
+    auto subtext = mstruct.isApproximate() ? tr_a.arg(query) : tr_e.arg(query);
+    if (exchange_rates && ExchangeRates::containsCurrency(mstruct))
+        subtext = tr_r.arg(subtext, QDateTime::fromSecsSinceEpoch(exchange_rates->date())
+                                        .date().toString(Qt::ISODate));
 
     mstruct.format(po);
     auto result = QString::fromStdString(mstruct.print(po));
@@ -147,7 +593,7 @@ shared_ptr<Item> Plugin::buildItem(const QString &query, MathStructure &mstruct)
     return StandardItem::make(
         u"qalc-res"_s,
         result,
-        mstruct.isApproximate() ? tr_a.arg(query) : tr_e.arg(query),
+        subtext,
         makeIcon,
         {
             {u"cpr"_s, tr_tr, [=](){ setClipboardText(result); }},
@@ -156,30 +602,452 @@ shared_ptr<Item> Plugin::buildItem(const QString &query, MathStructure &mstruct)
     );
 }
 
-variant<QStringList, MathStructure> Plugin::runQalculateLocked(const QueryContext &ctx,
-                                                               const EvaluationOptions &eo_)
+vector<shared_ptr<Item>> Plugin::buildRepresentationItems(const QString &query,
+                                                         const MathStructure &mstruct,
+                                                         const PrintOptions &po,
+                                                         const QString &result,
+                                                         const function<bool()> &isValid) const
+{
+    static const auto tr_tr = tr("Copy result to clipboard");
+    static const auto tr_frac = tr("Fraction of %1");
+    static const auto tr_mixed = tr("Mixed fraction of %1");
+    static const auto tr_hex = tr("Hexadecimal representation of %1");
+    static const auto tr_oct = tr("Octal representation of %1");
+    static const auto tr_bin = tr("Binary representation of %1");
+    static const auto tr_sci = tr("Scientific notation of %1");
+    static const auto tr_eng = tr("Engineering notation of %1");
+
+    // Printing in other bases and notations grows with the number of digits
+    vector<shared_ptr<Item>> items;
+    if (!mstruct.isNumber() || result.size() > REPRESENTATION_LENGTH)
+        return items;
+
+    const auto &number = mstruct.number();
+    const bool exact = !mstruct.isApproximate();
+    const bool integer = exact && number.isInteger();
+    const bool fraction = exact && number.isRational() && !number.isInteger();
+
+    struct Representation { const char *id; const QString &subtext; function<void(PrintOptions&)> apply; };
+    vector<Representation> representations;
+    if (fraction)
+    {
+        representations.push_back({"frac", tr_frac, [](auto &o){ o.number_fraction_format = FRACTION_FRACTIONAL; }});
+        representations.push_back({"mixed", tr_mixed, [](auto &o){ o.number_fraction_format = FRACTION_COMBINED; }});
+    }
+    if (integer)
+    {
+        representations.push_back({"hex", tr_hex, [](auto &o){ o.base = BASE_HEXADECIMAL; }});
+        representations.push_back({"oct", tr_oct, [](auto &o){ o.base = BASE_OCTAL; }});
+        representations.push_back({"bin", tr_bin, [](auto &o){ o.base = BASE_BINARY; }});
+    }
+    if (!number.isZero())
+    {
+        representations.push_back({"sci", tr_sci, [](auto &o){ o.min_exp = EXP_SCIENTIFIC; }});
+        representations.push_back({"eng", tr_eng, [](auto &o){ o.min_exp = EXP_BASE_3; }});
+    }
+
+    QStringList seen{result};
+    for (const auto &r : representations)
+    {
+        if (!isValid())
+            break;
+
+        auto po_ = po;
+        r.apply(po_);
+        MathStructure m(mstruct);
+        m.format(po_);
+        auto text = QString::fromStdString(m.print(po_));
+        if (seen.contains(text))
+            continue;
+        seen << text;
+
+        items.emplace_back(StandardItem::make(
+            u"qalc-%1"_s.arg(QString::fromLatin1(r.id)),
+            text,
+            r.subtext.arg(query),
+            makeIcon,
+            {{u"cpr"_s, tr_tr, [=](){ setClipboardText(text); }}}
+        ));
+    }
+
+    return items;
+}
+
+vector<shared_ptr<Item>> Plugin::buildCompletionItems(const QString &trigger,
+                                                     const QString &expression,
+                                                     uint64_t generation)
+{
+    static const auto tr_f = tr("Function: %1");
+    static const auto tr_u = tr("Unit: %1");
+    static const auto tr_v = tr("Variable: %1");
+    static const auto tr_p = tr("Prefix: %1");
+
+    vector<shared_ptr<Item>> items;
+
+    // Identifier characters at the end, not starting with a digit
+    auto begin = expression.size();
+    while (begin > 0 && (expression[begin - 1].isLetterOrNumber() || expression[begin - 1] == u'_'))
+        --begin;
+    while (begin < expression.size() && expression[begin].isDigit())
+        ++begin;
+    if (begin == expression.size())
+        return items;
+
+    const auto token = expression.mid(begin).toStdString();
+    for (const auto &e : name_trie.complete(generation, *qalc, token, COMPLETION_COUNT))
+    {
+        if (e.name == token)
+            continue;
+
+        const auto name = QString::fromStdString(e.name);
+        const auto title = QString::fromStdString(e.title);
+        const auto &subtext = e.kind == NameTrie::Kind::Function ? tr_f
+                              : e.kind == NameTrie::Kind::Unit   ? tr_u
+                              : e.kind == NameTrie::Kind::Variable ? tr_v : tr_p;
+
+        items.emplace_back(StandardItem::make(
+            u"qalc-cmp"_s,
+            name,
+            subtext.arg(title),
+            makeIcon,
+            {},
+            trigger + expression.left(begin) + name
+                + (e.kind == NameTrie::Kind::Function ? u"("_s : QString())
+        ));
+    }
+
+    return items;
+}
+
+shared_ptr<Item> Plugin::buildCorrectionItem(const QString &trigger, const QString &expression,
+                                             uint64_t generation)
+{
+    static const auto tr_c = tr("Did you mean this instead of %1?");
+
+    // Operator words and conversion targets the calculator does not list as items
+    static const QStringList keywords{
+        u"to"_s, u"and"_s, u"or"_s, u"xor"_s, u"not"_s, u"mod"_s, u"rem"_s, u"per"_s,
+        u"times"_s, u"plus"_s, u"minus"_s, u"hex"_s, u"oct"_s, u"bin"_s, u"base"_s,
+        u"bases"_s, u"fraction"_s, u"sci"_s, u"utc"_s, u"calendars"_s
+    };
+
+    QString corrected;
+    bool changed = false;
+    qsizetype i = 0;
+    while (i < expression.size())
+    {
+        if (!expression[i].isLetter())
+        {
+            corrected += expression[i++];
+            continue;
+        }
+
+        auto end = i;
+        while (end < expression.size()
+               && (expression[end].isLetterOrNumber() || expression[end] == u'_'))
+            ++end;
+
+        const auto word = expression.mid(i, end - i);
+        const auto w = word.toStdString();
+        if (word.size() > 2 && !keywords.contains(word, Qt::CaseInsensitive)
+            && !SpellingIndex::isKnown(*qalc, w))
+            if (auto c = spelling_index.correct(generation, *qalc, w); c)
+            {
+                corrected += QString::fromStdString(*c);
+                changed = true;
+                i = end;
+                continue;
+            }
+
+        corrected += word;
+        i = end;
+    }
+
+    if (!changed)
+        return {};
+
+    return StandardItem::make(
+        u"qalc-fix"_s,
+        corrected,
+        tr_c.arg(expression),
+        makeIcon,
+        {},
+        trigger + corrected
+    );
+}
+
+optional<vector<RankItem>> Plugin::buildSamplingItems(const QString &expression,
+                                                      const QString &variable,
+                                                      const QString &from, const QString &to,
+                                                      const Profiles &p,
+                                                      const function<bool()> &isValid)
+{
+    static const auto tr_s = tr("%1 for %2 from %3 to %4, minimum %5, maximum %6");
+    static const auto tr_c = tr("Copy sparkline to clipboard");
+    const auto lane = ExecutionLanes::Lane::Triggered;
+    const auto &profile = p.preview;
+
+    if (qalc->getPrecision() != profile.precision)
+        qalc->setPrecision(profile.precision);
+
+    auto unlocalize = [&](const QString &s){
+        return qalc->unlocalizeExpression(s.toStdString(), profile.eo.parse_options);
+    };
+
+    auto bound = [&](const QString &s) -> optional<double> {
+        auto r = runQalculateLocked(unlocalize(s), profile, lane, isValid);
+        if (auto *m = get_if<MathStructure>(&r); m && m->isNumber() && !m->number().isComplex())
+            return m->number().floatValue();
+        return {};
+    };
+
+    const auto a = bound(from);
+    const auto b = bound(to);
+    if (!a || !b)
+        return {};
+
+    vector<RankItem> items;
+    const auto expr = unlocalize(expression);
+    const auto var = variable.toStdString();
+
+    // Dense samples in double precision for the overview
+    vector<double> values;
+    if (auto sampler = Sampler::compile(qalc->parse(expr, profile.eo.parse_options), var,
+                                        profile.eo.parse_options.angle_unit);
+        sampler)
+        values = sampler->sample(*a, *b, SAMPLING_POINTS);
+
+    // The displayed values are evaluated by the calculator
+    vector<double> row_values;
+    for (int k = 0; k < SAMPLING_ROWS; ++k)
+    {
+        const auto x = u"(%1)+%2*((%3)-(%1))/%4"_s.arg(from).arg(k).arg(to).arg(SAMPLING_ROWS - 1);
+        const auto sample = u"(%1) where %2=%3"_s.arg(QString::fromStdString(expr), variable,
+                                                       QString::fromStdString(unlocalize(x)));
+        auto r = runQalculateLocked(sample.toStdString(), profile, lane, isValid);
+        if (!isValid())
+            return vector<RankItem>{};
+        if (auto *m = get_if<MathStructure>(&r); m)
+        {
+            if (m->isNumber() && !m->number().isComplex())
+                row_values.push_back(m->number().floatValue());
+            const auto xv = *a + (*b - *a) * k / (SAMPLING_ROWS - 1);
+            items.emplace_back(buildItem(u"%1, %2 = %3"_s.arg(expression, variable).arg(xv), *m,
+                                         p.po),
+                               .9f - (float)k * .01f);
+        }
+    }
+
+    if (values.empty())
+        values = row_values;
+
+    double lo = INFINITY, hi = -INFINITY;
+    for (auto v : values)
+        if (isfinite(v))
+        {
+            lo = min(lo, v);
+            hi = max(hi, v);
+        }
+
+    if (lo <= hi)
+    {
+        auto line = Sampler::sparkline(values, SPARKLINE_WIDTH);
+        items.emplace_back(
+            StandardItem::make(
+                u"qalc-plot"_s,
+                line,
+                tr_s.arg(expression, variable, from, to).arg(lo).arg(hi),
+                makeIcon,
+                {{u"cps"_s, tr_c, [=](){ setClipboardText(line); }}}
+            ),
+            1.0f
+        );
+    }
+
+    return items;
+}
+
+Plugin::Result Plugin::runQalculateLocked(const string &expression, const Profile &profile,
+                           ExecutionLanes::Lane lane, const function<bool()> &isValid,
+                           MathStructure *parsed)
 {
     MathStructure mstruct;
-    auto expression = qalc->unlocalizeExpression(ctx.query().toStdString(), eo.parse_options);
+    qalc->startControl();
+    qalc->calculate(&mstruct, expression, 0, profile.eo, parsed);
+    return awaitLocked(mstruct, lane, isValid);
+}
 
+optional<Plugin::Result> Plugin::evaluateTermsLocked(const string &expression, uint64_t generation,
+                                                     const Profile &profile,
+                                                     ExecutionLanes::Lane lane,
+                                                     const function<bool()> &isValid,
+                                                     MathStructure *parsed)
+{
+    // Conversions and conditions apply to the whole expression
+    auto s = expression;
+    string rest;
+    if (qalc->separateToExpression(s, rest, profile.eo, true)
+        || qalc->separateWhereExpression(s, rest, profile.eo))
+        return {};
+
+    // Parse errors are reported by the full evaluation
+    qalc->parse(parsed, expression, profile.eo.parse_options);
+    if (!Diagnostics::collect(*qalc).empty()
+        || (!parsed->isAddition() && !parsed->isMultiplication())
+        || parsed->size() > TermCache::max_terms
+        || parsed->containsUnknowns()
+        || parsed->containsType(STRUCT_UNIT, false, true, true)
+        || !ResultCache::isCacheable(*parsed))
+        return {};
+
+    vector<MathStructure> results;
+    results.reserve(parsed->size());
+    for (size_t i = 0; i < parsed->size(); ++i)
+    {
+        auto result = term_cache.get(generation, profile.name, profile.precision, (*parsed)[i]);
+        if (!result)
+        {
+            MathStructure term((*parsed)[i]);
+            qalc->startControl();
+            qalc->calculate(&term, 0, profile.eo);
+            auto r = awaitLocked(term, lane, isValid);
+            if (holds_alternative<monostate>(r))
+                return r;
+            else if (!holds_alternative<MathStructure>(r))
+                return {};
+            result = std::move(get<MathStructure>(r));
+        }
+
+        // Symbolic terms combine differently, e.g. sqrt(2) + sqrt(2)
+        if (!result->isNumber())
+            return {};
+        results.push_back(std::move(*result));
+    }
+    term_cache.put(generation, profile.name, profile.precision, *parsed, results);
+
+    MathStructure combined;
+    combined.setType(parsed->type());
+    for (const auto &r : results)
+        combined.addChild(r);
     qalc->startControl();
-    qalc->calculate(&mstruct, expression, 0, eo_);
+    qalc->calculate(&combined, 0, profile.eo);
+    return awaitLocked(combined, lane, isValid);
+}
+
+Plugin::Result Plugin::awaitLocked(MathStructure &mstruct, ExecutionLanes::Lane lane,
+                                   const function<bool()> &isValid)
+{
+    bool aborted = false;
     for (; qalc->busy(); QThread::msleep(10))
-        if (!ctx.isValid())
+        if (!aborted && (!isValid() || lanes.shouldYield(lane)))
+        {
             qalc->abort();
+            aborted = true;
+        }
     qalc->stopControl();
 
-    if (qalc->message())
+    if (aborted)
     {
-        QStringList errors;
-        for (auto msg = qalc->message(); msg; msg = qalc->nextMessage())
-            errors << QString::fromUtf8(qalc->message()->c_message());
-        return errors;
+        qalc->clearMessages();
+        return {};
     }
+    else if (auto diagnostics = Diagnostics::collect(*qalc); !diagnostics.empty())
+        return diagnostics;
     else
         return mstruct;
 }
 
+Plugin::Evaluation Plugin::evaluateLocked(const QString &query, const Profiles &p,
+                                          const Profile &profile, ExecutionLanes::Lane lane,
+                                          const function<bool()> &isValid,
+                                          chrono::milliseconds budget)
+{
+    QuerySample sample{.expression = query, .profile = QString::fromUtf8(profile.name)};
+    auto start = chrono::steady_clock::now();
+
+    if (qalc->getPrecision() != profile.precision)
+        qalc->setPrecision(profile.precision);
+
+    // Backspacing, retyping and switching lanes frequently repeat recent expressions
+    auto expression = qalc->unlocalizeExpression(query.toStdString(), profile.eo.parse_options);
+    if (auto cached = result_cache.get(p.generation, profile.name, expression, profile.precision);
+        cached)
+    {
+        sample.prepare = elapsedSince(start);
+        sample.cached = true;
+        return {std::move(*cached), sample};
+    }
+
+    // Plain unit and currency conversions skip parsing and simplification
+    if (auto conversion = profile.eo.parse_options.units_enabled ? Conversion::parse(expression)
+                                                                 : nullopt;
+        conversion)
+    {
+        auto converted = unit_graph.convert(definitions_generation, *qalc, *conversion);
+        if (!converted && exchange_rates)
+            converted = exchange_rates->convert(*conversion);
+        if (converted)
+        {
+            sample.prepare = elapsedSince(start);
+            return {std::move(*converted), sample};
+        }
+    }
+
+    // Number theory on 64 bit integers skips the arbitrary precision algorithms
+    if (profile.eo.parse_options.functions_enabled)
+        if (auto r = NumberTheory::evaluate(expression, *qalc, sieve.get()); r)
+        {
+            sample.prepare = elapsedSince(start);
+            return {std::move(*r), sample};
+        }
+
+    // Known bad input returns instantly
+    auto failure = negative_cache.get(p.generation, profile.name, expression);
+    if (!holds_alternative<monostate>(failure))
+    {
+        sample.prepare = elapsedSince(start);
+        sample.cached = true;
+        if (auto *errors = get_if<Diagnostics>(&failure))
+            return {std::move(*errors), sample};
+        sample.aborted = true;
+        return {monostate{}, sample};
+    }
+
+    sample.prepare = elapsedSince(start);
+    start = chrono::steady_clock::now();
+
+    const auto deadline = budget.count() ? start + budget : chrono::steady_clock::time_point::max();
+    auto withinBudget = [&]{ return isValid() && chrono::steady_clock::now() < deadline; };
+
+    MathStructure parsed;
+    function_memo.beginEvaluation(p.generation);
+    const auto heap = RecyclingPolicy::heap();
+    auto terms = evaluateTermsLocked(expression, p.generation, profile, lane, withinBudget,
+                                     &parsed);
+    auto result = terms ? std::move(*terms)
+                        : runQalculateLocked(expression, profile, lane, withinBudget, &parsed);
+    if (recycling.record(heap))
+        scheduleRecycling();
+    if (holds_alternative<MathStructure>(result))
+    {
+        if (ResultCache::isCacheable(parsed))
+            result_cache.put(p.generation, profile.name, expression, get<MathStructure>(result),
+                             profile.precision);
+    }
+    else if (holds_alternative<Diagnostics>(result))
+    {
+        if (ResultCache::isCacheable(parsed))
+            negative_cache.putError(p.generation, profile.name, expression,
+                                    get<Diagnostics>(result));
+    }
+    else if (chrono::steady_clock::now() >= deadline)
+        negative_cache.putTimeout(p.generation, profile.name, expression);
+
+    sample.calculate = elapsedSince(start);
+    sample.aborted = holds_alternative<monostate>(result);
+    return {std::move(result), sample};
+}
+
 vector<RankItem> Plugin::rankItems(QueryContext &ctx)
 {
     vector<RankItem> results;
@@ -188,36 +1056,119 @@ vector<RankItem> Plugin::rankItems(QueryContext &ctx)
     if (trimmed.isEmpty())
         return results;
 
-    auto eo_ = eo;
-    if (!ctx.trigger().isEmpty())
+    last_query = chrono::steady_clock::now().time_since_epoch().count();
+
+    const auto lane = ctx.trigger().isEmpty() ? ExecutionLanes::Lane::Global
+                                              : ExecutionLanes::Lane::Triggered;
+
+    shared_ptr<QueryRecorder> r;
     {
-        eo_.parse_options.functions_enabled = true;
-        eo_.parse_options.units_enabled = true;
-        eo_.parse_options.unknowns_enabled = true;
+        lock_guard lock(recorder_mutex);
+        r = recorder;
     }
+    if (r)
+        r->record(lane == ExecutionLanes::Lane::Global, trimmed);
 
-    lock_guard locker(qalculate_mutex);
-    auto var = runQalculateLocked(ctx, eo_);
+    // Pasted text may contain several independent expressions
+    const auto expressions = lane == ExecutionLanes::Lane::Triggered ? splitExpressions(trimmed)
+                                                                     : QStringList{trimmed};
+    const bool multiple = expressions.size() > 1;
 
-    if (!ctx.isValid())
+    auto ticket = lanes.acquire(lane, [&]{ return ctx.isValid(); });
+    if (!ticket)
         return results;
-    else if (holds_alternative<MathStructure>(var))
-        results.emplace_back(buildItem(trimmed, get<MathStructure>(var)), 1.0f);
-    else if (!ctx.trigger().isEmpty())
+
+    // Read under the ticket, definitions may have been reloaded while waiting
+    const auto p = currentProfiles();
+    const auto &profile = lane == ExecutionLanes::Lane::Global ? p->global : p->triggered;
+
+    if (auto m = RE_SAMPLING.match(trimmed); lane == ExecutionLanes::Lane::Triggered && m.hasMatch())
+        if (auto items = buildSamplingItems(m.captured(1), m.captured(2), m.captured(3),
+                                            m.captured(4), *p, [&]{ return ctx.isValid(); });
+            items)
+            return std::move(*items);
+
+    for (qsizetype i = 0; i < expressions.size(); ++i)
     {
-        static const auto tr_e = tr("Evaluation error.");
-        static const auto tr_d = tr("Visit documentation");
-        results.emplace_back(
-            StandardItem::make(
-                u"qalc-err"_s,
-                tr_e,
-                get<QStringList>(var).join(u", "_s),
-                makeIcon,
-                {{u"manual"_s, tr_d, [=](){ openUrl(URL_MANUAL); }}},
-                u""_s
-                )
-            , .0
-            );
+        const auto &expression = expressions[i];
+
+        // Descending scores keep the input order
+        const auto score = 1.0f - (float)i / (float)expressions.size();
+
+        auto [var, sample] = evaluateLocked(expression, *p, profile, lane, [&]{ return ctx.isValid(); },
+                                            lane == ExecutionLanes::Lane::Global ? GLOBAL_BUDGET
+                                                                                 : chrono::milliseconds{});
+        const auto start = chrono::steady_clock::now();
+
+        if (!ctx.isValid())
+        {
+            stats->add(sample);
+            return {};
+        }
+        else if (holds_alternative<monostate>(var))
+        {
+            stats->add(sample);
+            continue;
+        }
+        else if (auto *mstruct = get_if<MathStructure>(&var))
+        {
+            // Printed from the same evaluation, only when explicitly asked for
+            const auto unformatted = lane == ExecutionLanes::Lane::Triggered && !multiple
+                                         ? optional<MathStructure>(*mstruct) : nullopt;
+
+            auto item = buildItem(expression, *mstruct, p->po);
+            const auto result = item->text();
+            results.emplace_back(std::move(item), score);
+
+            if (unformatted)
+                for (auto &r : buildRepresentationItems(expression, *unformatted, p->po, result,
+                                                        [&]{ return ctx.isValid(); }))
+                    results.emplace_back(std::move(r), score * .9f);
+
+            // Unknowns are enabled on the trigger path, a typo evaluates symbolically
+            if (unformatted && unformatted->containsUnknowns())
+                if (auto c = buildCorrectionItem(ctx.trigger(), expression,
+                                                 definitions_generation); c)
+                    results.emplace_back(std::move(c), .55f);
+        }
+        else if (!ctx.trigger().isEmpty())
+        {
+            static const auto tr_e = tr("Evaluation error.");
+            static const auto tr_em = tr("Evaluation error in %1");
+            static const auto tr_w = tr("Evaluation warning.");
+            static const auto tr_wm = tr("Evaluation warning in %1");
+            static const auto tr_d = tr("Visit documentation");
+            const auto &diagnostics = get<Diagnostics>(var);
+            const bool error = diagnostics.maxSeverity() == MESSAGE_ERROR;
+            results.emplace_back(
+                StandardItem::make(
+                    u"qalc-err"_s,
+                    multiple ? (error ? tr_em : tr_wm).arg(expression) : (error ? tr_e : tr_w),
+                    diagnostics.text(),
+                    makeIcon,
+                    {{u"manual"_s, tr_d, [=](){ openUrl(URL_MANUAL); }}},
+                    u""_s
+                    )
+                , multiple ? score : .0f
+                );
+
+            if (!multiple)
+                if (auto c = buildCorrectionItem(ctx.trigger(), expression,
+                                                 definitions_generation); c)
+                    results.emplace_back(std::move(c), .55f);
+        }
+
+        sample.print = elapsedSince(start);
+        stats->add(sample);
+    }
+
+    // Below results and above errors, in order of relevance
+    if (lane == ExecutionLanes::Lane::Triggered && expressions.size() == 1)
+    {
+        auto completions = buildCompletionItems(ctx.trigger(), expressions[0],
+                                                definitions_generation);
+        for (size_t i = 0; i < completions.size(); ++i)
+            results.emplace_back(std::move(completions[i]), .5f - (float)i * .01f);
     }
 
     return results;
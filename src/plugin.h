@@ -1,12 +1,33 @@
 // Copyright (C) 2023-2024 Manuel Schneider
 
 #pragma once
+#include "diagnostics.h"
+#include "exchangerates.h"
+#include "executionlanes.h"
+#include "functionmemo.h"
+#include "nametrie.h"
+#include "negativecache.h"
+#include "primesieve.h"
+#include "profiles.h"
+#include "queryrecorder.h"
+#include "querystats.h"
+#include "recyclingpolicy.h"
+#include "resultcache.h"
+#include "server.h"
+#include "spellingindex.h"
+#include "termcache.h"
+#include "unitgraph.h"
+#include <QFileSystemWatcher>
+#include <QFuture>
+#include <QList>
 #include <QObject>
+#include <QTimer>
 #include <albert/extensionplugin.h>
 #include <albert/globalqueryhandler.h>
 #include <libqalculate/Calculator.h>
 #include <memory>
 #include <mutex>
+#include <variant>
 
 class Plugin : public albert::ExtensionPlugin,
                public albert::GlobalQueryHandler
@@ -15,6 +36,8 @@ class Plugin : public albert::ExtensionPlugin,
 
 public:
 
+    ~Plugin() override;
+
     void initialize() override;
 
     QString defaultTrigger() const override;
@@ -24,14 +47,111 @@ public:
 
 private:
 
-    std::variant<QStringList, MathStructure>
-    runQalculateLocked(const albert::QueryContext &, const EvaluationOptions &eo) ;
+    std::shared_ptr<const Profiles> currentProfiles() const;
+    void updateConfig(const std::function<void(Config&)> &modify);
+
+    // Keeps `future` until it finished, the destructor waits for pending work
+    void addBackgroundTask(const QFuture<void> &future);
+
+    void scheduleRecycling();
+    void recycleCalculator();
+
+    void watchLocalDefinitions();
+    void reloadLocalDefinitions();
+
+    // Starts a new definitions generation and rebuilds the indexes over the definitions
+    void updateIndexesLocked();
+
+    void setServerEnabled(bool enabled);
+    void setRecordingMode(int mode);
+    void setMemoizationScope(int scope);
+    void setSieveSize(int mib);
+    std::vector<Server::Response> serve(const std::vector<Server::Request> &requests);
+
+    // Aborted evaluations yield std::monostate
+    using Result = std::variant<std::monostate, Diagnostics, MathStructure>;
+
+    struct Evaluation
+    {
+        Result result;
+        QuerySample sample;  // print timing is up to the caller
+    };
+
+    // A zero budget does not limit the evaluation time
+    Evaluation evaluateLocked(const QString &expression, const Profiles &profiles,
+                              const Profile &profile, ExecutionLanes::Lane lane,
+                              const std::function<bool()> &isValid,
+                              std::chrono::milliseconds budget = {});
+
+    // Evaluates the terms of a sum or product separately, reusing numeric results of
+    // unchanged terms of the previous expression. Returns nothing if the expression is not
+    // a sum or product of numeric terms, it is evaluated as a whole then.
+    std::optional<Result> evaluateTermsLocked(const std::string &expression,
+                                              std::uint64_t generation, const Profile &profile,
+                                              ExecutionLanes::Lane lane,
+                                              const std::function<bool()> &isValid,
+                                              MathStructure *parsed);
+
+    // Waits for the calculation started on `mstruct`
+    Result awaitLocked(MathStructure &mstruct, ExecutionLanes::Lane lane,
+                       const std::function<bool()> &isValid);
+
+    Result runQalculateLocked(const std::string &expression, const Profile &profile,
+                       ExecutionLanes::Lane lane, const std::function<bool()> &isValid,
+                       MathStructure *parsed = nullptr);
+
+    std::shared_ptr<albert::Item> buildItem(const QString &query, MathStructure &mstruct,
+                                            const PrintOptions &po) const;
+
+    // Alternative representations of a numeric result, skipping those equal to `result`.
+    // Nothing for long results, stops formatting once `isValid` returns false.
+    std::vector<std::shared_ptr<albert::Item>>
+    buildRepresentationItems(const QString &query, const MathStructure &mstruct,
+                             const PrintOptions &po, const QString &result,
+                             const std::function<bool()> &isValid) const;
+
+    // Completes the identifier at the end of `expression`
+    std::vector<std::shared_ptr<albert::Item>>
+    buildCompletionItems(const QString &trigger, const QString &expression,
+                         std::uint64_t generation);
+
+    // Replaces unknown identifiers in `expression` by their closest known names
+    std::shared_ptr<albert::Item> buildCorrectionItem(const QString &trigger,
+                                                      const QString &expression,
+                                                      std::uint64_t generation);
 
-    std::shared_ptr<albert::Item> buildItem(const QString &query, MathStructure &mstruct) const;
+    // Items for "expression for x from a to b", nothing if the bounds do not evaluate
+    std::optional<std::vector<albert::RankItem>>
+    buildSamplingItems(const QString &expression, const QString &variable, const QString &from,
+                       const QString &to, const Profiles &profiles,
+                       const std::function<bool()> &isValid);
 
     QString iconPath;
     std::unique_ptr<Calculator> qalc;
-    EvaluationOptions eo;
-    PrintOptions po;
-    std::mutex qalculate_mutex;
+    Config config;
+    std::shared_ptr<const Profiles> profiles;
+    mutable std::mutex profiles_mutex;
+    ExecutionLanes lanes;
+    ResultCache result_cache{256};
+    TermCache term_cache;
+    NegativeCache negative_cache{256};
+    std::uint64_t definitions_generation = 0;  // Changed under a lane ticket
+    UnitGraph unit_graph;
+    NameTrie name_trie;
+    SpellingIndex spelling_index;
+    FunctionMemo function_memo{4096};
+    std::unique_ptr<PrimeSieve> sieve;  // Replaced under a lane ticket
+    std::shared_ptr<const ExchangeRates> exchange_rates;  // Swapped under a lane ticket
+    QFileSystemWatcher definitions_watcher;
+    QTimer definitions_reload_timer;
+    QStringList changed_definitions;
+    std::unique_ptr<Server> server;
+    std::shared_ptr<QueryRecorder> recorder;
+    std::mutex recorder_mutex;
+    std::unique_ptr<QueryStats> stats;
+    RecyclingPolicy recycling;
+    QTimer recycling_timer;
+    std::atomic<bool> recycling_scheduled = false;
+    std::atomic<std::chrono::steady_clock::rep> last_query = 0;
+    QList<QFuture<void>> background_tasks;  // GUI thread only
 };
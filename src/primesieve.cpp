@@ -0,0 +1,405 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "primesieve.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <libqalculate/Calculator.h>
+#include <libqalculate/Function.h>
+#include <map>
+#include <numeric>
+#include <string_view>
+#include <sys/mman.h>
+#include <unistd.h>
+using namespace std;
+
+namespace {
+const char MAGIC[8] = {'q', 'p', 's', 'i', 'e', 'v', 'e', '1'};
+const size_t SEGMENT_BYTES = 32 << 10;
+const uint64_t SEGMENT_ODDS = SEGMENT_BYTES * 8;
+
+struct Header
+{
+    char magic[8];
+    uint64_t bytes;
+};
+
+vector<uint32_t> simpleSieve(uint32_t limit)
+{
+    vector<bool> composite(limit + 1);
+    vector<uint32_t> primes;
+    for (uint32_t i = 2; i <= limit; ++i)
+        if (!composite[i])
+        {
+            primes.push_back(i);
+            for (uint64_t j = (uint64_t)i * i; j <= limit; j += i)
+                composite[j] = true;
+        }
+    return primes;
+}
+
+uint64_t mulmod(uint64_t a, uint64_t b, uint64_t m)
+{ return (uint64_t)((unsigned __int128)a * b % m); }
+
+uint64_t powmod(uint64_t b, uint64_t e, uint64_t m)
+{
+    uint64_t r = 1;
+    b %= m;
+    for (; e; e >>= 1)
+    {
+        if (e & 1)
+            r = mulmod(r, b, m);
+        b = mulmod(b, b, m);
+    }
+    return r;
+}
+
+// Deterministic for all 64 bit integers
+bool millerRabin(uint64_t n)
+{
+    if (n < 2)
+        return false;
+    for (uint64_t p : {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37})
+        if (n % p == 0)
+            return n == p;
+
+    uint64_t d = n - 1;
+    int s = 0;
+    for (; (d & 1) == 0; d >>= 1)
+        ++s;
+
+    for (uint64_t a : {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37})
+    {
+        auto x = powmod(a, d, n);
+        if (x == 1 || x == n - 1)
+            continue;
+        bool witness = true;
+        for (int r = 1; r < s && witness; ++r)
+        {
+            x = mulmod(x, x, n);
+            witness = x != n - 1;
+        }
+        if (witness)
+            return false;
+    }
+    return true;
+}
+
+// Brent's cycle detection with batched gcds
+uint64_t pollardRho(uint64_t n)
+{
+    if (n % 2 == 0)
+        return 2;
+
+    for (uint64_t c = 1;; ++c)
+    {
+        auto f = [&](uint64_t x){ return (mulmod(x, x, n) + c) % n; };
+        uint64_t y = 2, x = 2, ys = 2, q = 1, g = 1;
+        const uint64_t m = 128;
+
+        for (uint64_t r = 1; g == 1; r <<= 1)
+        {
+            x = y;
+            for (uint64_t i = 0; i < r; ++i)
+                y = f(y);
+            for (uint64_t k = 0; k < r && g == 1; k += m)
+            {
+                ys = y;
+                for (uint64_t i = 0; i < min(m, r - k); ++i)
+                {
+                    y = f(y);
+                    q = mulmod(q, x > y ? x - y : y - x, n);
+                }
+                g = gcd(q, n);
+            }
+        }
+
+        if (g == n)  // Overshot, step back one at a time
+            do
+            {
+                ys = f(ys);
+                g = gcd(x > ys ? x - ys : ys - x, n);
+            }
+            while (g == 1);
+
+        if (g != n)
+            return g;
+    }
+}
+}
+
+PrimeSieve::PrimeSieve(const filesystem::path &file, size_t bytes)
+{
+    small_primes = simpleSieve(1 << 16);
+
+    segments = bytes / SEGMENT_BYTES;
+    if (segments == 0)
+        return;
+
+    map_size = sizeof(Header) + segments + segments * SEGMENT_BYTES;
+    const auto fd = ::open(file.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        segments = 0;
+        return;
+    }
+
+    Header header{};
+    const bool valid = ::pread(fd, &header, sizeof(header), 0) == sizeof(header)
+                       && memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0
+                       && header.bytes == segments * SEGMENT_BYTES;
+    if (!valid && ::ftruncate(fd, 0) != 0)
+        segments = 0;
+    if (segments && ::ftruncate(fd, (off_t)map_size) == 0)
+    {
+        void *p = ::mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED)
+            map = static_cast<unsigned char*>(p);
+    }
+    ::close(fd);
+
+    if (!map)
+    {
+        segments = 0;
+        map_size = 0;
+        return;
+    }
+
+    if (!valid)
+    {
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.bytes = segments * SEGMENT_BYTES;
+        memcpy(map, &header, sizeof(header));
+    }
+
+    done = map + sizeof(Header);
+    bits = done + segments;
+    sieved.assign(done, done + segments);
+    base_primes = simpleSieve((uint32_t)sqrt((double)limit()) + 1);
+}
+
+PrimeSieve::~PrimeSieve()
+{
+    if (!map)
+        return;
+
+    // The flags must not reach the file before the bits do
+    if (!unsynced.empty() && ::msync(map, map_size, MS_SYNC) == 0)
+        for (auto segment : unsynced)
+            done[segment] = 1;
+
+    ::munmap(map, map_size);
+}
+
+uint64_t PrimeSieve::limit() const { return segments * SEGMENT_ODDS * 2; }
+
+const vector<uint32_t> &PrimeSieve::smallPrimes() const { return small_primes; }
+
+void PrimeSieve::sieveSegment(size_t segment)
+{
+    auto *s = bits + segment * SEGMENT_BYTES;
+    memset(s, 0, SEGMENT_BYTES);
+
+    // Odd index i represents 2i+1
+    const uint64_t first = segment * SEGMENT_ODDS;
+    const uint64_t last = first + SEGMENT_ODDS;
+    if (first == 0)
+        s[0] |= 1;  // 1 is not prime
+
+    for (auto p : base_primes)
+    {
+        if (p == 2)
+            continue;
+        const uint64_t square = (uint64_t)p * p;
+        if (square / 2 >= last)
+            break;
+        // First odd multiple of p not below the segment and not below p^2
+        uint64_t m = max(square, ((2 * first + 1 + p - 1) / p) * p);
+        if (m % 2 == 0)
+            m += p;
+        for (uint64_t i = m / 2; i < last; i += p)
+            s[(i - first) >> 3] |= (unsigned char)(1 << ((i - first) & 7));
+    }
+
+    sieved[segment] = true;
+    unsynced.push_back(segment);
+}
+
+bool PrimeSieve::composite(uint64_t i)
+{
+    const auto segment = i / SEGMENT_ODDS;
+    if (!sieved[segment])
+        sieveSegment(segment);
+    return bits[i >> 3] & (1 << (i & 7));
+}
+
+optional<bool> PrimeSieve::isPrime(uint64_t n)
+{
+    if (n >= limit())
+        return {};
+    if (n < 3)
+        return n == 2;
+    if (n % 2 == 0)
+        return false;
+
+    lock_guard lock(mutex);
+    return !composite(n / 2);
+}
+
+optional<uint64_t> PrimeSieve::nextPrime(uint64_t n)
+{
+    if (n <= 2)
+        return limit() > 2 ? optional<uint64_t>(2) : nullopt;
+
+    lock_guard lock(mutex);
+    for (uint64_t i = n / 2; 2 * i + 1 < limit(); ++i)
+        if (2 * i + 1 >= n && !composite(i))
+            return 2 * i + 1;
+    return {};
+}
+
+bool NumberTheory::isPrime(uint64_t n, PrimeSieve *sieve)
+{
+    if (sieve)
+        if (auto p = sieve->isPrime(n); p)
+            return *p;
+    return millerRabin(n);
+}
+
+optional<uint64_t> NumberTheory::nextPrime(uint64_t n, PrimeSieve *sieve)
+{
+    if (sieve)
+        if (auto p = sieve->nextPrime(n); p)
+            return p;
+
+    if (n <= 2)
+        return 2;
+    for (uint64_t c = n | 1; c >= n; c += 2)  // Stops on overflow
+        if (millerRabin(c))
+            return c;
+    return {};
+}
+
+vector<pair<uint64_t, int>> NumberTheory::factor(uint64_t n, PrimeSieve *sieve)
+{
+    map<uint64_t, int> factors;
+
+    static const auto fallback = simpleSieve(1 << 16);
+    const auto &small = sieve ? sieve->smallPrimes() : fallback;
+    for (auto p : small)
+    {
+        if ((uint64_t)p * p > n)
+            break;
+        for (; n % p == 0; n /= p)
+            ++factors[p];
+    }
+
+    vector<uint64_t> stack;
+    if (n > 1)
+        stack.push_back(n);
+    while (!stack.empty())
+    {
+        auto m = stack.back();
+        stack.pop_back();
+        if (isPrime(m, sieve))
+            ++factors[m];
+        else
+        {
+            auto d = pollardRho(m);
+            stack.push_back(d);
+            stack.push_back(m / d);
+        }
+    }
+
+    return {factors.begin(), factors.end()};
+}
+
+uint64_t NumberTheory::totient(uint64_t n, PrimeSieve *sieve)
+{
+    if (n == 0)
+        return 0;
+    auto result = n;
+    for (const auto &[p, e] : factor(n, sieve))
+        result = result / p * (p - 1);
+    return result;
+}
+
+optional<MathStructure> NumberTheory::evaluate(const string &expression, Calculator &qalc,
+                                               PrimeSieve *sieve)
+{
+    // name(digits) with optional spaces
+    string_view s(expression);
+    auto skipSpaces = [&]{
+        while (!s.empty() && isspace((unsigned char)s.front()))
+            s.remove_prefix(1);
+    };
+
+    skipSpaces();
+    size_t i = 0;
+    while (i < s.size() && islower((unsigned char)s[i]))
+        ++i;
+    const auto name = s.substr(0, i);
+    s.remove_prefix(i);
+
+    skipSpaces();
+    if (s.empty() || s.front() != '(')
+        return {};
+    s.remove_prefix(1);
+    skipSpaces();
+
+    uint64_t n;
+    auto [end, ec] = from_chars(s.data(), s.data() + s.size(), n);
+    if (ec != errc() || end == s.data())
+        return {};
+    s.remove_prefix(size_t(end - s.data()));
+
+    skipSpaces();
+    if (s.empty() || s.front() != ')')
+        return {};
+    s.remove_prefix(1);
+    skipSpaces();
+    if (!s.empty())
+        return {};
+
+    // Local definitions may replace or shadow the builtin functions
+    const string function_name(name);
+    const auto *f = qalc.getActiveFunction(function_name);
+    if (!f || f->subtype() != SUBTYPE_FUNCTION || f->isLocal() || f->referenceName() != name
+        || qalc.getActiveVariable(function_name) || qalc.getActiveUnit(function_name))
+        return {};
+
+    auto number = [](uint64_t v){ return MathStructure(Number(to_string(v))); };
+
+    if (name == "isprime")
+        return MathStructure(isPrime(n, sieve) ? 1 : 0, 1, 0);
+
+    else if (name == "nextprime")
+    {
+        if (auto p = nextPrime(n, sieve); p)
+            return number(*p);
+    }
+
+    else if (name == "totient" && n > 0)
+        return number(totient(n, sieve));
+
+    else if (name == "factor" && n > 1)
+    {
+        optional<MathStructure> result;
+        for (const auto &[p, e] : factor(n, sieve))
+        {
+            auto term = number(p);
+            if (e > 1)
+                term.raise(MathStructure(e, 1, 0));
+            if (!result)
+                result = term;
+            else
+                result->multiply(term, true);
+        }
+        return result;
+    }
+
+    return {};
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <libqalculate/MathStructure.h>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+class Calculator;
+
+///
+/// Segmented sieve of Eratosthenes in a memory-mapped cache file.
+///
+/// One bit per odd number marks composites. Segments of 32 KiB are sieved on first
+/// access, a flag per segment in the file header records which ones reached the file, so
+/// the sieve builds up lazily and persists across sessions. The flags of segments sieved
+/// in this session are written on destruction, once their bits are synced. Changing the
+/// size discards the file.
+///
+class PrimeSieve
+{
+public:
+
+    /// A size of zero disables the sieve, queries beyond the limit return nothing.
+    PrimeSieve(const std::filesystem::path &file, size_t bytes);
+    ~PrimeSieve();
+
+    /// Numbers below the limit are covered.
+    std::uint64_t limit() const;
+
+    std::optional<bool> isPrime(std::uint64_t n);
+
+    /// Returns the smallest prime greater than or equal to `n`.
+    std::optional<std::uint64_t> nextPrime(std::uint64_t n);
+
+    /// Primes below 2^16, for trial division.
+    const std::vector<std::uint32_t> &smallPrimes() const;
+
+private:
+
+    bool composite(std::uint64_t odd_index);
+    void sieveSegment(size_t segment);
+
+    std::mutex mutex;
+    std::vector<std::uint32_t> small_primes;
+    std::vector<std::uint32_t> base_primes;  // Up to the square root of the limit
+    unsigned char *map = nullptr;
+    size_t map_size = 0;
+    size_t segments = 0;
+    unsigned char *done = nullptr;  // One flag per segment
+    unsigned char *bits = nullptr;
+    std::vector<bool> sieved;  // Including segments whose flags are not written yet
+    std::vector<size_t> unsynced;
+
+};
+
+///
+/// Integer number theory on 64 bit operands.
+///
+/// Primality is decided by the sieve where it reaches, by deterministic Miller-Rabin
+/// otherwise. Factorization divides by small primes and splits the remaining cofactors
+/// with Brent's variant of Pollard's rho.
+///
+/// evaluate() answers whole expressions calling the builtin factor, isprime, nextprime or
+/// totient function on a single integer literal, others are left to the calculator.
+///
+namespace NumberTheory
+{
+
+bool isPrime(std::uint64_t n, PrimeSieve *sieve);
+
+/// Returns nothing if the next prime exceeds 64 bits.
+std::optional<std::uint64_t> nextPrime(std::uint64_t n, PrimeSieve *sieve);
+
+/// Prime factors with multiplicities in ascending order.
+std::vector<std::pair<std::uint64_t, int>> factor(std::uint64_t n, PrimeSieve *sieve);
+
+std::uint64_t totient(std::uint64_t n, PrimeSieve *sieve);
+
+/// Returns nothing if the expression is not a supported call on a 64 bit integer or if
+/// the name does not refer to the builtin function in `qalc`.
+std::optional<MathStructure> evaluate(const std::string &expression, Calculator &qalc,
+                                      PrimeSieve *sieve);
+
+}
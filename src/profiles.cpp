@@ -0,0 +1,63 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "profiles.h"
+#include <algorithm>
+#include <atomic>
+using namespace std;
+
+namespace {
+const auto PREVIEW_PRECISION = 8;
+atomic<uint64_t> generation_counter = 0;
+
+bool equalIgnoringPrecision(const Config &a, const Config &b)
+{
+    return a.angle_unit == b.angle_unit
+           && a.parsing_mode == b.parsing_mode
+           && a.units_in_global_query == b.units_in_global_query
+           && a.functions_in_global_query == b.functions_in_global_query;
+}
+}
+
+shared_ptr<const Profiles> Profiles::make(const Config &config, const Profiles *previous)
+{
+    EvaluationOptions eo;
+
+    // evaluation options
+    eo.auto_post_conversion = POST_CONVERSION_BEST;
+    eo.structuring = STRUCTURING_SIMPLIFY;
+
+    // parse options
+    eo.parse_options.angle_unit = config.angle_unit;
+    eo.parse_options.functions_enabled = config.functions_in_global_query;
+    eo.parse_options.limit_implicit_multiplication = true;
+    eo.parse_options.parsing_mode = config.parsing_mode;
+    eo.parse_options.units_enabled = config.units_in_global_query;
+    eo.parse_options.unknowns_enabled = false;
+
+    auto eo_triggered = eo;
+    eo_triggered.parse_options.functions_enabled = true;
+    eo_triggered.parse_options.units_enabled = true;
+    eo_triggered.parse_options.unknowns_enabled = true;
+
+    auto eo_preview = eo_triggered;
+    eo_preview.approximation = APPROXIMATION_APPROXIMATE;
+
+    // print options
+    PrintOptions po;
+    po.indicate_infinite_series = true;
+    po.interval_display = INTERVAL_DISPLAY_SIGNIFICANT_DIGITS;
+    po.lower_case_e = true;
+    //po.preserve_precision = true;  // https://github.com/albertlauncher/plugins/issues/92
+    po.use_unicode_signs = true;
+    //po.abbreviate_names = true;
+
+    return make_shared<const Profiles>(Profiles{
+        .global = {"global", eo, config.global_precision},
+        .triggered = {"triggered", eo_triggered, config.precision},
+        .preview = {"preview", eo_preview, min(config.global_precision, PREVIEW_PRECISION)},
+        .po = po,
+        .config = config,
+        .generation = previous && equalIgnoringPrecision(previous->config, config)
+                          ? previous->generation : ++generation_counter
+    });
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <cstdint>
+#include <libqalculate/includes.h>
+#include <memory>
+
+///
+/// The user configuration the option profiles are derived from.
+///
+struct Config
+{
+    AngleUnit angle_unit = ANGLE_UNIT_RADIANS;
+    ParsingMode parsing_mode = PARSING_MODE_CONVENTIONAL;
+    int precision = 16;  // triggered
+    int global_precision = 16;
+    bool units_in_global_query = false;
+    bool functions_in_global_query = false;
+};
+
+///
+/// A complete set of options for a single evaluation.
+///
+struct Profile
+{
+    const char *name;
+    EvaluationOptions eo;
+    int precision;
+};
+
+///
+/// Immutable option profiles built from a Config.
+///
+/// Profiles are rebuilt only when the configuration changes. Queries select a profile
+/// by pointer and keep the set alive as long as they need it.
+///
+struct Profiles
+{
+    /// Basic math used by the global query handler.
+    Profile global;
+
+    /// Full feature set used by the triggered query handler.
+    Profile triggered;
+
+    /// Cheap approximate evaluation used for previews.
+    Profile preview;
+
+    /// Options used to format and print results.
+    PrintOptions po;
+
+    /// The configuration the profiles were built from.
+    Config config;
+
+    /// Increases with every rebuild that changes evaluation results. Used to invalidate
+    /// derived caches. Precision changes keep the generation, caches handle precision.
+    std::uint64_t generation;
+
+    static std::shared_ptr<const Profiles> make(const Config &config,
+                                                const Profiles *previous = nullptr);
+};
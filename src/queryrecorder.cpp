@@ -0,0 +1,60 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "queryrecorder.h"
+#include <QDateTime>
+#include <albert/logging.h>
+using namespace Qt::StringLiterals;
+using namespace std;
+
+QueryRecorder::QueryRecorder(const filesystem::path &path, Mode m) : file(path), mode(m)
+{
+    filesystem::create_directories(path.parent_path());
+    if (file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+        file.write(u"# session %1\n"_s.arg(QDateTime::currentDateTime().toString(Qt::ISODate))
+                   .toUtf8());
+    else
+        WARN << "Failed to open query recording" << file.fileName() << file.errorString();
+    timer.start();
+}
+
+void QueryRecorder::record(bool global, const QString &query)
+{
+    lock_guard lock(mutex);
+    if (!file.isOpen())
+        return;
+
+    QString text;
+    QChar m;
+    switch (mode) {
+    case Mode::Plain:    text = query;         m = u'p'; break;
+    case Mode::Redacted: text = redact(query); m = u'r'; break;
+    case Mode::Hashed:   text = hash(query);   m = u'h'; break;
+    }
+
+    // Tabs and newlines would break the line format
+    text.replace(u'\t', u' ').replace(u'\n', u' ');
+
+    file.write(u"%1\t%2\t%3\t%4\n"_s.arg(timer.elapsed()).arg(global ? u"g"_s : u"t"_s).arg(m)
+               .arg(text).toUtf8());
+    file.flush();
+}
+
+QString QueryRecorder::redact(const QString &query)
+{
+    QString redacted = query;
+    for (auto &c : redacted)
+        if (c.isDigit())
+            c = u'1';
+    return redacted;
+}
+
+QString QueryRecorder::hash(const QString &query)
+{
+    quint64 h = 14695981039346656037ull;
+    for (const auto c : query.toUtf8())
+    {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    return u"%1"_s.arg(h, 16, 16, u'0');
+}
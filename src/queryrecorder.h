@@ -0,0 +1,38 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+#include <filesystem>
+#include <mutex>
+
+///
+/// Appends the sequence and timing of queries to a recording file.
+///
+/// Each session starts with a line `# session <ISO date>`. Each query is recorded as
+/// tab separated line `<ms since session start> <lane g|t> <mode p|r|h> <text>`.
+/// Redaction replaces every digit by `1` and keeps the structure of the expression,
+/// hashing replaces the expression by its 64 bit FNV-1a hash.
+///
+class QueryRecorder
+{
+public:
+
+    enum class Mode { Plain, Redacted, Hashed };
+
+    QueryRecorder(const std::filesystem::path &file, Mode mode);
+
+    void record(bool global, const QString &query);
+
+    static QString redact(const QString &query);
+    static QString hash(const QString &query);
+
+private:
+
+    std::mutex mutex;
+    QFile file;
+    QElapsedTimer timer;
+    const Mode mode;
+
+};
@@ -0,0 +1,122 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "querystats.h"
+#include <QDateTime>
+#include <algorithm>
+#include <albert/logging.h>
+#include <cmath>
+using namespace Qt::StringLiterals;
+using namespace std::chrono;
+using namespace std;
+
+namespace {
+const qint64 max_log_size = 1 << 20;
+const size_t max_recent_slow = 100;
+
+size_t bucket(microseconds us)
+{ return (size_t)max(0.0, 8.0 * log2((double)max<long long>(1, us.count()))); }
+
+microseconds bucketUpperBound(size_t b)
+{ return microseconds((long long)exp2((b + 1) / 8.0)); }
+}
+
+QueryStats::QueryStats(const filesystem::path &path) : file(path), log_path(file.fileName())
+{ filesystem::create_directories(path.parent_path()); }
+
+void QueryStats::setThreshold(milliseconds t)
+{
+    lock_guard lock(mutex);
+    threshold_ = t;
+}
+
+milliseconds QueryStats::threshold() const
+{
+    lock_guard lock(mutex);
+    return threshold_;
+}
+
+void QueryStats::add(const QuerySample &sample)
+{
+    lock_guard lock(mutex);
+
+    ++histogram[min(bucket(sample.total()), bucket_count - 1)];
+    ++count_;
+
+    if (sample.total() < threshold_)
+        return;
+
+    recent_slow.push_back(sample);
+    if (recent_slow.size() > max_recent_slow)
+        recent_slow.pop_front();
+
+    log(sample);
+}
+
+void QueryStats::log(const QuerySample &s)
+{
+    if (file.isOpen() && file.size() > max_log_size)
+    {
+        file.close();
+        const auto rotated = log_path + u".1"_s;
+        QFile::remove(rotated);
+        if (!file.rename(rotated))
+        {
+            WARN << "Failed to rotate slow query log" << log_path << file.errorString();
+            file.remove();  // Keeps the log bounded
+        }
+        file.setFileName(log_path);
+    }
+
+    if (!file.isOpen() && !file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+    {
+        WARN << "Failed to open slow query log" << file.fileName() << file.errorString();
+        return;
+    }
+
+    auto expression = s.expression;
+    expression.replace(u'\n', u' ');
+
+    file.write(u"%1 total=%2us prepare=%3us calculate=%4us print=%5us profile=%6%7%8 %9\n"_s
+               .arg(QDateTime::currentDateTime().toString(Qt::ISODate))
+               .arg(s.total().count()).arg(s.prepare.count()).arg(s.calculate.count())
+               .arg(s.print.count()).arg(s.profile)
+               .arg(s.aborted ? u" aborted"_s : QString())
+               .arg(s.cached ? u" cached"_s : QString())
+               .arg(expression).toUtf8());
+    file.flush();
+}
+
+vector<QuerySample> QueryStats::slowest(size_t n) const
+{
+    lock_guard lock(mutex);
+    vector<QuerySample> v(recent_slow.begin(), recent_slow.end());
+    sort(v.begin(), v.end(), [](const auto &a, const auto &b){ return a.total() > b.total(); });
+    if (v.size() > n)
+        v.resize(n);
+    return v;
+}
+
+microseconds QueryStats::percentile(double p) const
+{
+    if (count_ == 0)
+        return {};
+
+    const auto rank = (size_t)ceil(p * count_);
+    size_t seen = 0;
+    for (size_t b = 0; b < bucket_count; ++b)
+        if ((seen += histogram[b]) >= rank)
+            return bucketUpperBound(b);
+    return bucketUpperBound(bucket_count - 1);
+}
+
+array<microseconds, 3> QueryStats::percentiles() const
+{
+    lock_guard lock(mutex);
+    return {percentile(.5), percentile(.95), percentile(.99)};
+}
+
+size_t QueryStats::count() const
+{
+    lock_guard lock(mutex);
+    return count_;
+}
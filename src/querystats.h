@@ -0,0 +1,70 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <QFile>
+#include <QString>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+///
+/// Timings of a single evaluation.
+///
+struct QuerySample
+{
+    QString expression;
+    QString profile;
+    std::chrono::microseconds prepare{0};
+    std::chrono::microseconds calculate{0};
+    std::chrono::microseconds print{0};
+    bool aborted = false;
+    bool cached = false;
+
+    std::chrono::microseconds total() const { return prepare + calculate + print; }
+};
+
+///
+/// Latency statistics since startup and a log of slow evaluations.
+///
+/// Latencies are kept in a logarithmic histogram with eight buckets per octave. Samples
+/// exceeding the threshold are appended to the slow query log, which is rotated once it
+/// exceeds 1 MiB, and kept in memory for the settings.
+///
+class QueryStats
+{
+public:
+
+    explicit QueryStats(const std::filesystem::path &log_file);
+
+    void setThreshold(std::chrono::milliseconds threshold);
+    std::chrono::milliseconds threshold() const;
+
+    void add(const QuerySample &sample);
+
+    /// Slowest of the recent slow samples, descending.
+    std::vector<QuerySample> slowest(size_t n) const;
+
+    /// Latency percentiles p50, p95 and p99.
+    std::array<std::chrono::microseconds, 3> percentiles() const;
+
+    size_t count() const;
+
+private:
+
+    void log(const QuerySample &sample);
+    std::chrono::microseconds percentile(double p) const;
+
+    static constexpr size_t bucket_count = 8 * 40;
+
+    mutable std::mutex mutex;
+    QFile file;
+    const QString log_path;  // The file name changes while rotating
+    std::chrono::milliseconds threshold_{100};
+    std::array<size_t, bucket_count> histogram{};
+    size_t count_ = 0;
+    std::deque<QuerySample> recent_slow;
+
+};
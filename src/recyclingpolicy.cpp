@@ -0,0 +1,75 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "recyclingpolicy.h"
+#include <fstream>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+using namespace std;
+
+namespace {
+const size_t trim_threshold = 32 << 20;
+}
+
+void RecyclingPolicy::setMaxQueries(unsigned n) { max_queries = n; }
+
+void RecyclingPolicy::setMaxGrowthMiB(unsigned mib)
+{
+    max_growth_mib = mib;
+    growth_effective = true;
+}
+
+void RecyclingPolicy::reset()
+{
+    queries = 0;
+    growth = 0;
+    growth_effective = true;
+}
+
+bool RecyclingPolicy::restart(const Heap &before, const Heap &after)
+{
+    queries = 0;
+    const auto returned = (int64_t)before.allocated - (int64_t)after.allocated;
+    growth = max<int64_t>(0, growth - returned);
+    if (exceedsGrowth())
+        growth_effective = false;
+    return growth_effective;
+}
+
+bool RecyclingPolicy::record(const Heap &before)
+{
+    auto after = heap();
+
+#ifdef __GLIBC__
+    // Huge intermediate results leave the freed heap mapped
+    if (after.mapped > before.mapped + trim_threshold)
+    {
+        malloc_trim(0);
+        after = heap();
+    }
+#endif
+
+    // Other threads allocate meanwhile, the sum approximates the evaluation's share
+    const auto delta = (int64_t)after.allocated - (int64_t)before.allocated;
+    for (auto g = growth.load(); !growth.compare_exchange_weak(g, max<int64_t>(0, g + delta)););
+
+    const auto n = ++queries;
+    return (max_queries && n >= max_queries) || (growth_effective && exceedsGrowth());
+}
+
+bool RecyclingPolicy::exceedsGrowth() const
+{ return max_growth_mib && (growth >> 20) >= (int64_t)max_growth_mib; }
+
+RecyclingPolicy::Heap RecyclingPolicy::heap()
+{
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+    const auto info = mallinfo2();
+    return {info.uordblks + info.hblkhd, info.arena + info.hblkhd};
+#else
+    size_t size = 0, resident = 0;
+    ifstream("/proc/self/statm") >> size >> resident;
+    resident *= (size_t)sysconf(_SC_PAGESIZE);
+    return {resident, resident};
+#endif
+}
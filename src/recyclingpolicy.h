@@ -0,0 +1,57 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+///
+/// Decides when the long-lived Calculator should be replaced by a fresh instance.
+///
+/// Tracks the number of evaluations and the heap growth attributable to them, i.e. the
+/// sum of the heap deltas around the evaluations. Evaluations growing the mapped heap
+/// considerably are followed by returning free heap memory to the system.
+///
+class RecyclingPolicy
+{
+public:
+
+    struct Heap
+    {
+        size_t allocated = 0;
+        size_t mapped = 0;
+    };
+
+    /// 0 disables the limit.
+    void setMaxQueries(unsigned n);
+
+    /// 0 disables the limit. Applies the limit again after a replacement did not help.
+    void setMaxGrowthMiB(unsigned mib);
+
+    /// Starts tracking the first instance.
+    void reset();
+
+    /// Starts tracking a replacement. The memory it returned is subtracted from the
+    /// growth, the rest keeps counting. Returns false if the growth is still above the
+    /// limit, i.e. replacing does not return the memory. The growth limit is not applied
+    /// anymore in that case.
+    bool restart(const Heap &before, const Heap &after);
+
+    /// Records an evaluation that started at `before`.
+    /// Returns true if the instance exceeded one of the limits.
+    bool record(const Heap &before);
+
+    /// The heap of the process, the resident memory where glibc is not available.
+    static Heap heap();
+
+private:
+
+    bool exceedsGrowth() const;
+
+    std::atomic<unsigned> max_queries = 0;
+    std::atomic<unsigned> max_growth_mib = 0;
+    std::atomic<unsigned> queries = 0;
+    std::atomic<std::int64_t> growth = 0;
+    std::atomic<bool> growth_effective = true;
+
+};
@@ -0,0 +1,109 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "resultcache.h"
+#include <libqalculate/Function.h>
+#include <libqalculate/Variable.h>
+#include <set>
+using namespace std;
+
+namespace {
+const set<string> volatile_names = {
+    "now", "today", "yesterday", "tomorrow", "timestamp", "uptime",
+    "rand", "randn", "randpoisson"
+};
+}
+
+ResultCache::ResultCache(size_t c) : capacity(c) {}
+
+string ResultCache::makeKey(const char *profile, const string &expression)
+{
+    string key(profile);
+    key += '\0';
+    key += expression;
+    return key;
+}
+
+void ResultCache::resetIfStale(uint64_t g)
+{
+    if (generation != g)
+    {
+        lru.clear();
+        index.clear();
+        generation = g;
+    }
+}
+
+optional<MathStructure> ResultCache::get(uint64_t g, const char *profile,
+                                         const string &expression, int precision)
+{
+    lock_guard lock(mutex);
+    resetIfStale(g);
+
+    if (auto it = index.find(makeKey(profile, expression)); it != index.end())
+    {
+        const auto &e = *it->second;
+        if (!e.result.isApproximate())
+        {
+            lru.splice(lru.begin(), lru, it->second);
+            return e.result;
+        }
+        else if (e.precision >= precision)
+        {
+            lru.splice(lru.begin(), lru, it->second);
+            MathStructure rounded(e.result);
+            rounded.setPrecision(precision, true);
+            return rounded;
+        }
+    }
+
+    return {};
+}
+
+void ResultCache::put(uint64_t g, const char *profile, const string &expression,
+                      const MathStructure &result, int precision)
+{
+    lock_guard lock(mutex);
+    resetIfStale(g);
+
+    auto key = makeKey(profile, expression);
+    if (auto it = index.find(key); it != index.end())
+    {
+        auto &e = *it->second;
+        if (!result.isApproximate() || (e.result.isApproximate() && e.precision <= precision))
+        {
+            e.result = result;
+            e.precision = precision;
+        }
+        lru.splice(lru.begin(), lru, it->second);
+        return;
+    }
+
+    lru.push_front({key, result, precision});
+    index.emplace(std::move(key), lru.begin());
+
+    if (lru.size() > capacity)
+    {
+        index.erase(lru.back().key);
+        lru.pop_back();
+    }
+}
+
+void ResultCache::clear()
+{
+    lock_guard lock(mutex);
+    lru.clear();
+    index.clear();
+}
+
+bool ResultCache::isCacheable(const MathStructure &m)
+{
+    if ((m.isFunction() && volatile_names.contains(m.function()->referenceName()))
+        || (m.isVariable() && volatile_names.contains(m.variable()->referenceName())))
+        return false;
+
+    for (size_t i = 0; i < m.size(); ++i)
+        if (!isCacheable(m[i]))
+            return false;
+
+    return true;
+}
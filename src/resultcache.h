@@ -0,0 +1,58 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <cstdint>
+#include <libqalculate/MathStructure.h>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+///
+/// Least recently used cache of evaluated expressions.
+///
+/// Entries are keyed by profile and unlocalized expression and are dropped as a whole
+/// when the profile generation changes.
+///
+/// Exact results are independent of the precision. Approximate results are kept at the
+/// highest precision computed so far and re-rounded on demand, i.e. they serve requests of
+/// equal or lower precision. Changing the precision is therefore free for everything
+/// already evaluated at a higher precision.
+///
+class ResultCache
+{
+public:
+
+    explicit ResultCache(size_t capacity);
+
+    std::optional<MathStructure> get(std::uint64_t generation, const char *profile,
+                                     const std::string &expression, int precision);
+
+    void put(std::uint64_t generation, const char *profile,
+             const std::string &expression, const MathStructure &result, int precision);
+
+    void clear();
+
+    /// Returns false if the parsed expression depends on time or randomness.
+    static bool isCacheable(const MathStructure &parsed);
+
+private:
+
+    void resetIfStale(std::uint64_t generation);
+    static std::string makeKey(const char *profile, const std::string &expression);
+
+    struct Entry
+    {
+        std::string key;
+        MathStructure result;
+        int precision;
+    };
+
+    std::mutex mutex;
+    const size_t capacity;
+    std::uint64_t generation = 0;
+    std::list<Entry> lru;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+
+};
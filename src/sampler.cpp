@@ -0,0 +1,82 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "sampler.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+using namespace std;
+
+Sampler::Sampler(Bytecode b) : bytecode(std::move(b)) {}
+
+optional<Sampler> Sampler::compile(const MathStructure &parsed, const string &variable,
+                                   AngleUnit angle_unit)
+{
+    if (auto bytecode = Bytecode::compile(parsed, {variable}, angle_unit); bytecode)
+        return Sampler(std::move(*bytecode));
+    return {};
+}
+
+vector<double> Sampler::sample(double from, double to, size_t count) const
+{
+    vector<double> result(count);
+    const double step = count > 1 ? (to - from) / double(count - 1) : 0;
+
+    array<double, Bytecode::BLOCK> x;
+    const double *args[] = {x.data()};
+    vector<double> workspace;
+
+    for (size_t offset = 0; offset < count; offset += Bytecode::BLOCK)
+    {
+        const auto n = min(Bytecode::BLOCK, count - offset);
+        for (size_t i = 0; i < n; ++i)
+            x[i] = from + step * double(offset + i);
+        bytecode.evaluate(args, n, result.data() + offset, workspace);
+    }
+
+    return result;
+}
+
+QString Sampler::sparkline(const vector<double> &values, size_t width)
+{
+    static const QString blocks = QString::fromUtf8("▁▂▃▄▅▆▇█");
+
+    width = min(width, values.size());
+    if (width == 0)
+        return {};
+
+    vector<double> columns(width, NAN);
+    for (size_t c = 0; c < width; ++c)
+    {
+        const auto begin = c * values.size() / width;
+        const auto end = (c + 1) * values.size() / width;
+        double sum = 0;
+        size_t n = 0;
+        for (auto i = begin; i < end; ++i)
+            if (isfinite(values[i]))
+            {
+                sum += values[i];
+                ++n;
+            }
+        if (n)
+            columns[c] = sum / double(n);
+    }
+
+    double lo = INFINITY, hi = -INFINITY;
+    for (auto v : columns)
+        if (isfinite(v))
+        {
+            lo = min(lo, v);
+            hi = max(hi, v);
+        }
+
+    QString line;
+    for (auto v : columns)
+        if (!isfinite(v))
+            line += u' ';
+        else if (hi == lo)
+            line += blocks[blocks.size() / 2];
+        else
+            line += blocks[min<qsizetype>(blocks.size() - 1,
+                                          qsizetype((v - lo) / (hi - lo) * double(blocks.size())))];
+    return line;
+}
@@ -0,0 +1,37 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include "bytecode.h"
+#include <QString>
+#include <libqalculate/MathStructure.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+///
+/// Samples a parsed expression of one variable in double precision.
+///
+/// The expression is compiled once to bytecode and evaluated in blocks of contiguous
+/// points. Expressions the bytecode does not support fail to compile.
+///
+class Sampler
+{
+public:
+
+    /// Returns nothing if the structure contains unsupported operations.
+    static std::optional<Sampler> compile(const MathStructure &parsed, const std::string &variable,
+                                          AngleUnit angle_unit);
+
+    /// Evaluates `count` evenly spaced points from `from` to `to`, both inclusive.
+    std::vector<double> sample(double from, double to, size_t count) const;
+
+    /// Renders values as block characters, averaging to `width` columns.
+    static QString sparkline(const std::vector<double> &values, size_t width);
+
+private:
+
+    explicit Sampler(Bytecode bytecode);
+
+    Bytecode bytecode;
+
+};
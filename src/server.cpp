@@ -0,0 +1,145 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "server.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
+#include <QtConcurrentRun>
+#include <QtEndian>
+#include <albert/logging.h>
+#include <algorithm>
+#include <deque>
+#include <limits>
+using namespace std;
+
+namespace {
+const quint32 max_frame_size = 1 << 20;
+const int max_threads = 2;
+}
+
+struct Server::Connection
+{
+    QPointer<QLocalSocket> socket;
+    QByteArray buffer;
+    vector<Request> pending;
+    deque<shared_ptr<atomic<bool>>> unanswered;
+    bool busy = false;
+};
+
+Server::Server(const QString &socket_path, Handler h) :
+    handler(std::move(h)),
+    server(make_unique<QLocalServer>())
+{
+    pool.setMaxThreadCount(max_threads);
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    QLocalServer::removeServer(socket_path);  // Stale socket of a previous session
+
+    if (server->listen(socket_path))
+        INFO << "Serving evaluations on" << socket_path;
+    else
+        WARN << "Failed to listen on" << socket_path << server->errorString();
+
+    connect(server.get(), &QLocalServer::newConnection, this, &Server::onNewConnection);
+}
+
+Server::~Server()
+{
+    // The handler must not outlive its owner
+    for (const auto &weak : connections)
+        if (auto c = weak.lock(); c)
+            for (const auto &cancelled : c->unanswered)
+                *cancelled = true;
+    pool.waitForDone();
+}
+
+void Server::onNewConnection()
+{
+    while (auto *socket = server->nextPendingConnection())
+    {
+        auto c = make_shared<Connection>();
+        c->socket = socket;
+        erase_if(connections, [](const auto &weak){ return weak.expired(); });
+        connections.push_back(c);
+
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+
+        // Nobody waits for the responses anymore
+        connect(socket, &QLocalSocket::disconnected, this, [c]
+        {
+            for (const auto &cancelled : c->unanswered)
+                *cancelled = true;
+        });
+
+        connect(socket, &QLocalSocket::readyRead, this, [this, c]
+        {
+            c->buffer += c->socket->readAll();
+
+            while (c->buffer.size() >= 4)
+            {
+                const auto len = qFromBigEndian<quint32>(c->buffer.constData());
+                if (len < 5 || len > max_frame_size)
+                {
+                    WARN << "Closing connection with malformed frame";
+                    c->socket->disconnectFromServer();
+                    return;
+                }
+                if ((quint32)c->buffer.size() < 4 + len)
+                    break;
+
+                const auto *payload = c->buffer.constData() + 4;
+
+                if (payload[0] & 2)
+                    for (const auto &cancelled : c->unanswered)
+                        *cancelled = true;
+
+                auto cancelled = make_shared<atomic<bool>>(false);
+                c->unanswered.push_back(cancelled);
+                c->pending.push_back({
+                    .global = (payload[0] & 1) != 0,
+                    .launcher = (payload[0] & 4) != 0,
+                    .deadline_ms = qFromBigEndian<quint32>(payload + 1),
+                    .expression = QString::fromUtf8(payload + 5, len - 5),
+                    .cancelled = cancelled
+                });
+                c->buffer.remove(0, 4 + len);
+            }
+
+            processNext(c);
+        });
+    }
+}
+
+void Server::processNext(const shared_ptr<Connection> &c)
+{
+    if (c->busy || c->pending.empty() || !c->socket)
+        return;
+
+    c->busy = true;
+    auto batch = std::move(c->pending);
+    c->pending.clear();
+
+    auto future = QtConcurrent::run(&pool, [h = handler, batch = std::move(batch)]
+                                    { return h(batch); })
+    .then(this, [this, c](const vector<Response> &responses)
+    {
+        c->busy = false;
+        if (!c->socket)
+            return;
+
+        for (const auto &r : responses)
+        {
+            const auto text = r.text.toUtf8();
+            const auto calculate = min<qint64>(r.calculate.count(), numeric_limits<quint32>::max());
+            QByteArray frame(4 + 6, Qt::Uninitialized);
+            qToBigEndian<quint32>(6 + text.size(), frame.data());
+            frame[4] = static_cast<char>(r.status);
+            frame[5] = r.cached ? 1 : 0;
+            qToBigEndian<quint32>(calculate, frame.data() + 6);
+            frame += text;
+            c->socket->write(frame);
+            c->unanswered.pop_front();
+        }
+
+        processNext(c);
+    });
+}
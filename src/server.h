@@ -0,0 +1,76 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+class QLocalServer;
+class QLocalSocket;
+
+///
+/// Serves evaluations over a local socket.
+///
+/// Frames are a 32 bit big endian payload length followed by the payload. Requests carry
+/// a flags byte (bit 0: global profile, bit 1: supersede, bit 2: launcher priority), a 32
+/// bit big endian deadline in milliseconds (0: the budget of global queries) and the UTF-8
+/// expression. A superseding request cancels all unanswered requests of the connection,
+/// like a keystroke cancels the previous query. Requests with launcher priority are
+/// scheduled like queries of the launcher handler of their profile, others yield to the
+/// launcher. Responses carry a status byte (see Status), a flags byte (bit 0: cache hit),
+/// the 32 bit big endian calculation time spent on the request in microseconds, including
+/// preempted attempts, and the UTF-8 result or error text.
+///
+/// Requests may be pipelined. All requests available on a connection are handed to the
+/// handler as one batch, responses are sent in request order.
+///
+class Server : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    enum class Status : quint8 { Ok, Error, Aborted };
+
+    struct Request
+    {
+        bool global;
+        bool launcher;
+        unsigned deadline_ms;
+        QString expression;
+        std::shared_ptr<const std::atomic<bool>> cancelled;
+    };
+
+    struct Response
+    {
+        Status status;
+        bool cached;
+        QString text;
+        std::chrono::microseconds calculate{0};
+    };
+
+    /// Called in a worker thread of the server. Must return one response per request. The
+    /// server cancels all requests and waits for the handler when it is destroyed.
+    using Handler = std::function<std::vector<Response>(const std::vector<Request> &)>;
+
+    Server(const QString &socket_path, Handler handler);
+    ~Server() override;
+
+private:
+
+    struct Connection;
+
+    void onNewConnection();
+    void processNext(const std::shared_ptr<Connection> &);
+
+    Handler handler;
+    QThreadPool pool;  // Long running requests must not starve the global pool
+    std::unique_ptr<QLocalServer> server;
+    std::vector<std::weak_ptr<Connection>> connections;
+
+};
@@ -0,0 +1,141 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "spellingindex.h"
+#include "lowercase.h"
+#include <algorithm>
+#include <libqalculate/Calculator.h>
+#include <numeric>
+#include <unordered_set>
+using namespace std;
+
+void SpellingIndex::clear()
+{
+    lock_guard lock(mutex);
+    nodes.clear();
+    edges.clear();
+    generation = 0;
+}
+
+uint32_t SpellingIndex::distance(const string &a, const string &b)
+{
+    vector<uint32_t> row(b.size() + 1);
+    iota(row.begin(), row.end(), 0);
+    for (size_t i = 1; i <= a.size(); ++i)
+    {
+        uint32_t diagonal = row[0];
+        row[0] = (uint32_t)i;
+        for (size_t j = 1; j <= b.size(); ++j)
+        {
+            const auto above = row[j];
+            row[j] = min({row[j] + 1, row[j - 1] + 1, diagonal + (a[i - 1] == b[j - 1] ? 0 : 1)});
+            diagonal = above;
+        }
+    }
+    return row[b.size()];
+}
+
+void SpellingIndex::insert(string key, string name)
+{
+    if (nodes.empty())
+    {
+        nodes.push_back({std::move(key), std::move(name), {}});
+        return;
+    }
+
+    uint32_t n = 0;
+    for (;;)
+    {
+        const auto d = distance(key, nodes[n].key);
+        auto it = ranges::find_if(nodes[n].children,
+                                  [&](uint32_t e){ return edges[e].distance == d; });
+        if (it == nodes[n].children.end())
+        {
+            nodes[n].children.push_back((uint32_t)edges.size());
+            edges.push_back({d, (uint32_t)nodes.size()});
+            nodes.push_back({std::move(key), std::move(name), {}});
+            return;
+        }
+        n = edges[*it].node;
+    }
+}
+
+void SpellingIndex::update(uint64_t g, Calculator &calculator)
+{
+    lock_guard lock(mutex);
+    if (generation != g)
+        rebuild(g, calculator);
+}
+
+void SpellingIndex::rebuild(uint64_t g, Calculator &calculator)
+{
+    generation = g;
+
+    nodes.clear();
+    edges.clear();
+
+    unordered_set<string> seen;
+    auto addItem = [&](const ExpressionItem *item) {
+        if (!item->isActive() || item->isHidden())
+            return;
+        for (size_t i = 1; i <= item->countNames(); ++i)  // One based
+            if (const auto &name = item->getName(i).name; name.size() > 2)
+                if (auto key = toLower(name); seen.insert(key).second)
+                    insert(std::move(key), name);
+    };
+
+    for (const auto *f : calculator.functions)
+        addItem(f);
+    for (const auto *u : calculator.units)
+        addItem(u);
+    for (const auto *v : calculator.variables)
+        addItem(v);
+}
+
+optional<string> SpellingIndex::correct(uint64_t g, Calculator &calculator, const string &word)
+{
+    lock_guard lock(mutex);
+
+    if (generation != g)
+        rebuild(g, calculator);
+
+    if (nodes.empty())
+        return {};
+
+    const auto key = toLower(word);
+    const uint32_t tolerance = key.size() <= 4 ? 1 : 2;
+
+    optional<string> best;
+    uint32_t best_distance = tolerance + 1;
+
+    vector<uint32_t> stack{0};
+    while (!stack.empty())
+    {
+        const auto &node = nodes[stack.back()];
+        stack.pop_back();
+
+        const auto d = distance(key, node.key);
+        if (d < best_distance)
+        {
+            best = node.name;
+            best_distance = d;
+        }
+
+        for (auto e : node.children)
+            if (edges[e].distance + tolerance >= d && edges[e].distance <= d + tolerance)
+                stack.push_back(edges[e].node);
+    }
+
+    return best;
+}
+
+bool SpellingIndex::isKnown(Calculator &calculator, const string &word)
+{
+    if (calculator.getActiveExpressionItem(word))
+        return true;
+
+    for (size_t i = 1; i < word.size(); ++i)
+        if (calculator.getPrefix(word.substr(0, i)) && calculator.getActiveUnit(word.substr(i)))
+            return true;
+
+    return false;
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+class Calculator;
+
+///
+/// BK-tree over the names of all active functions, units and variables.
+///
+/// Names are compared case-insensitively by Levenshtein distance. Since the distance is a
+/// metric, a lookup only descends into children whose edge distance is within the
+/// tolerance of the distance to the current node, which visits a small fraction of the
+/// names. Nodes and edges are kept in arrays and referenced by index.
+///
+/// Inserting all names takes far longer than a lookup. The owner updates the tree in the
+/// tasks loading definitions, a lookup only builds it if it was cleared.
+///
+class SpellingIndex
+{
+public:
+
+    /// Rebuilds the tree unless it was built for the definitions `generation`.
+    void update(std::uint64_t generation, Calculator &calculator);
+
+    /// Returns the closest name within one edit for short words, two otherwise.
+    std::optional<std::string> correct(std::uint64_t generation, Calculator &calculator,
+                                       const std::string &word);
+
+    /// Returns true if the calculator knows `word`, possibly as prefixed unit.
+    static bool isKnown(Calculator &calculator, const std::string &word);
+
+    void clear();
+
+private:
+
+    struct Node
+    {
+        std::string key;             // Lower case
+        std::string name;
+        std::vector<std::uint32_t> children;  // Indices of child edges
+    };
+
+    struct Edge
+    {
+        std::uint32_t distance;
+        std::uint32_t node;
+    };
+
+    void rebuild(std::uint64_t generation, Calculator &calculator);
+    void insert(std::string key, std::string name);
+    static std::uint32_t distance(const std::string &a, const std::string &b);
+
+    std::mutex mutex;
+    std::uint64_t generation = 0;
+    std::vector<Node> nodes;
+    std::vector<Edge> edges;
+
+};
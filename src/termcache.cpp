@@ -0,0 +1,46 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "termcache.h"
+#include <algorithm>
+using namespace std;
+
+optional<MathStructure> TermCache::get(uint64_t g, const char *profile, int precision,
+                                       const MathStructure &term)
+{
+    lock_guard lock(mutex);
+    if (generation != g)
+        return {};
+
+    auto it = previous.find(profile);
+    if (it == previous.end() || it->second.precision != precision)
+        return {};
+
+    for (const auto &t : it->second.terms)
+        if (t.parsed.equals(term))
+            return t.result;
+    return {};
+}
+
+void TermCache::put(uint64_t g, const char *profile, int precision,
+                    const MathStructure &parsed, const vector<MathStructure> &results)
+{
+    lock_guard lock(mutex);
+    if (generation != g)
+    {
+        previous.clear();
+        generation = g;
+    }
+
+    auto &p = previous[profile];
+    p.precision = precision;
+    p.terms.clear();
+    for (size_t i = 0; i < min({parsed.size(), results.size(), max_terms}); ++i)
+        p.terms.push_back({parsed[i], results[i]});
+}
+
+void TermCache::clear()
+{
+    lock_guard lock(mutex);
+    previous.clear();
+    generation = 0;
+}
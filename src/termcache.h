@@ -0,0 +1,56 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include <cstdint>
+#include <libqalculate/MathStructure.h>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+///
+/// Evaluated terms of the previous expression per profile.
+///
+/// Consecutive queries usually differ by a character appended to the last term of a sum
+/// or product. The plugin splits the parsed expression into its top-level terms, looks
+/// up the numeric results of unchanged terms here and evaluates only the changed ones.
+/// Terms are matched structurally, the previous terms are replaced by those of every
+/// evaluated expression. Entries are dropped when the generation or the precision changes.
+///
+class TermCache
+{
+public:
+
+    static constexpr size_t max_terms = 64;
+
+    /// Returns the result of a term equal to `term` of the previous expression.
+    std::optional<MathStructure> get(std::uint64_t generation, const char *profile,
+                                     int precision, const MathStructure &term);
+
+    /// Replaces the terms of the previous expression. `results` are parallel to the
+    /// children of `parsed`.
+    void put(std::uint64_t generation, const char *profile, int precision,
+             const MathStructure &parsed, const std::vector<MathStructure> &results);
+
+    void clear();
+
+private:
+
+    struct Term
+    {
+        MathStructure parsed;
+        MathStructure result;
+    };
+
+    struct Previous
+    {
+        int precision = 0;
+        std::vector<Term> terms;
+    };
+
+    std::mutex mutex;
+    std::uint64_t generation = 0;
+    std::map<std::string, Previous> previous;  // By profile name
+
+};
@@ -0,0 +1,149 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#include "unitgraph.h"
+#include <libqalculate/Calculator.h>
+#include <libqalculate/Prefix.h>
+#include <libqalculate/Unit.h>
+using namespace std;
+
+namespace {
+const size_t MAX_PAIRS = 1024;
+}
+
+void UnitGraph::clear()
+{
+    lock_guard lock(mutex);
+    nodes.clear();
+    pairs.clear();
+    generation = 0;
+}
+
+void UnitGraph::update(uint64_t g, Calculator &calculator)
+{
+    lock_guard lock(mutex);
+    if (generation != g)
+        rebuild(g, calculator);
+}
+
+void UnitGraph::rebuild(uint64_t g, Calculator &calculator)
+{
+    nodes.clear();
+    pairs.clear();
+    generation = g;
+
+    EvaluationOptions exact;
+    exact.approximation = APPROXIMATION_EXACT;
+
+    for (auto *u : calculator.units)
+    {
+        if (!u->isActive() || u->isCurrency() || u->subtype() == SUBTYPE_COMPOSITE_UNIT)
+            continue;
+
+        auto *base = u->baseUnit();
+        if (base->subtype() == SUBTYPE_COMPOSITE_UNIT)
+            continue;
+
+        if (u == base)
+        {
+            nodes.emplace(u, Node{base, 1, Number(1, 1)});
+            continue;
+        }
+
+        if (u->hasNonlinearRelationTo(base) || u->hasApproximateRelationTo(base))
+            continue;
+
+        MathStructure value(1, 1, 0), exponent(1, 1, 0);
+        u->convertToBaseUnit(value, exponent);
+        value.eval(exact);
+        if (value.isNumber() && value.number().isRational())
+            nodes.emplace(u, Node{base, u->baseExponent(), value.number()});
+    }
+}
+
+optional<UnitGraph::Operand> UnitGraph::resolve(Calculator &calculator, const string &name) const
+{
+    // The parser would not read these as units
+    if (calculator.getActiveVariable(name) || calculator.getActiveFunction(name))
+        return {};
+
+    if (auto *u = calculator.getActiveUnit(name))
+        return Operand{u, nullptr};
+
+    // Prefixed units, bail out if the split is ambiguous
+    optional<Operand> operand;
+    for (size_t i = 1; i < name.size(); ++i)
+        if (auto *p = calculator.getPrefix(name.substr(0, i)); p)
+            if (auto *u = calculator.getActiveUnit(name.substr(i)); u)
+            {
+                if (operand)
+                    return {};
+                operand = Operand{u, p};
+            }
+    return operand;
+}
+
+optional<Number> UnitGraph::baseFactor(const Operand &operand, const Node *&node) const
+{
+    auto it = nodes.find(operand.unit);
+    if (it == nodes.end())
+        return {};
+    node = &it->second;
+
+    Number factor(node->factor);
+    if (operand.prefix && !factor.multiply(operand.prefix->value()))
+        return {};
+    return factor;
+}
+
+optional<UnitGraph::Pair> UnitGraph::makePair(Calculator &calculator, const string &from,
+                                              const string &to) const
+{
+    auto a = resolve(calculator, from);
+    auto b = resolve(calculator, to);
+    if (!a || !b)
+        return {};
+
+    const Node *na, *nb;
+    auto fa = baseFactor(*a, na);
+    auto fb = baseFactor(*b, nb);
+    if (!fa || !fb || na->base != nb->base || na->exponent != nb->exponent)
+        return {};
+
+    if (!fa->divide(*fb))
+        return {};
+
+    return Pair{*fa, b->unit, b->prefix};
+}
+
+optional<MathStructure> UnitGraph::convert(uint64_t g, Calculator &calculator,
+                                           const Conversion &conversion)
+{
+    lock_guard lock(mutex);
+
+    if (generation != g)
+        rebuild(g, calculator);
+
+    auto key = conversion.from;
+    key += '\0';
+    key += conversion.to;
+
+    auto it = pairs.find(key);
+    if (it == pairs.end())
+    {
+        if (pairs.size() >= MAX_PAIRS)
+            pairs.clear();
+        it = pairs.emplace(key, makePair(calculator, conversion.from, conversion.to)).first;
+    }
+
+    const auto &pair = it->second;
+    if (!pair)
+        return {};
+
+    Number value(conversion.value);
+    if (value.isApproximate() || !value.multiply(pair->factor))
+        return {};
+
+    MathStructure result(value);
+    result.multiply(MathStructure(pair->unit, pair->prefix));
+    return result;
+}
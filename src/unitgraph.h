@@ -0,0 +1,76 @@
+// Copyright (c) 2026 Manuel Schneider
+
+#pragma once
+#include "conversion.h"
+#include <cstdint>
+#include <libqalculate/MathStructure.h>
+#include <libqalculate/Number.h>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+class Calculator;
+class Prefix;
+class Unit;
+
+///
+/// Fast path for plain unit conversions like "5 km to mi".
+///
+/// Every unit with a linear, exact relation to its base unit is a node holding the rational
+/// factor to that base unit. Units sharing a base unit are connected through it, the factor
+/// of a pair is the quotient of both base factors. Pair factors are memoized by the names
+/// used in the query, hence a repeated conversion is a single multiplication.
+///
+/// Currencies, offsets (e.g. temperatures), approximate definitions, composite units and
+/// names that are ambiguous with variables or functions are left to the full evaluation.
+/// The owner calls update() whenever the calculator loaded definitions, so conversions
+/// find the graph built.
+///
+class UnitGraph
+{
+public:
+
+    /// Rebuilds the graph unless it was built for the definitions `generation`.
+    void update(std::uint64_t generation, Calculator &calculator);
+
+    /// Returns nothing if the fast path does not apply. Updates the graph first.
+    std::optional<MathStructure> convert(std::uint64_t generation, Calculator &calculator,
+                                         const Conversion &conversion);
+
+    /// Drops all references into the calculator.
+    void clear();
+
+private:
+
+    struct Node
+    {
+        Unit *base;
+        int exponent;
+        Number factor;  // Value in base units per unit
+    };
+
+    struct Operand
+    {
+        Unit *unit;
+        Prefix *prefix;
+    };
+
+    struct Pair
+    {
+        Number factor;
+        Unit *unit;
+        Prefix *prefix;
+    };
+
+    void rebuild(std::uint64_t generation, Calculator &calculator);
+    std::optional<Operand> resolve(Calculator &calculator, const std::string &name) const;
+    std::optional<Number> baseFactor(const Operand &operand, const Node *&node) const;
+    std::optional<Pair> makePair(Calculator &calculator, const std::string &from,
+                                 const std::string &to) const;
+
+    std::mutex mutex;
+    std::uint64_t generation = 0;
+    std::unordered_map<const Unit*, Node> nodes;
+    std::unordered_map<std::string, std::optional<Pair>> pairs;  // Also remembers misses
+
+};
@@ -0,0 +1,341 @@
+// Copyright (c) 2026 Manuel Schneider
+//
+// Evaluates newline separated expressions from a file or stdin using the evaluation
+// semantics of the plugin. Expressions are distributed over a pool of worker processes
+// forked from a warm calculator template, results are printed in input order.
+
+#include "calculatortemplate.h"
+#include "profiles.h"
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fcntl.h>
+#include <libqalculate/Calculator.h>
+#include <map>
+#include <poll.h>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+struct Options
+{
+    Config config;
+    bool triggered = true;
+    int jobs = (int)max(1u, thread::hardware_concurrency());
+    int timeout = 10000;
+    const char *input = nullptr;
+};
+
+struct Worker
+{
+    pid_t pid;
+    int in;   // write end, expressions
+    int out;  // read end, results
+    string outbuf;
+    string inbuf;
+    deque<size_t> pending;
+    CalculatorTemplate::MemoryUsage memory;
+};
+
+[[noreturn]] void usage(const char *argv0, int status)
+{
+    fprintf(status ? stderr : stdout,
+            "Usage: %s [options] [file]\n"
+            "\n"
+            "Evaluates one expression per line read from file or stdin.\n"
+            "\n"
+            "  -j <n>         Number of worker processes (default: number of cores)\n"
+            "  -p <n>         Precision (default: 16)\n"
+            "  -a <n>         Angle unit, 0 none, 1 radians, 2 degrees, 3 gradians (default: 1)\n"
+            "  -m <n>         Parsing mode, 0 adaptive, 1 implicit first, 2 conventional (default: 2)\n"
+            "  -t <ms>        Timeout per expression (default: 10000)\n"
+            "  -g             Use the restricted global query profile\n"
+            "  -h             Show this help\n",
+            argv0);
+    exit(status);
+}
+
+Options parseArgs(int argc, char **argv)
+{
+    Options o;
+    for (int c; (c = getopt(argc, argv, "j:p:a:m:t:gh")) != -1;)
+        switch (c)
+        {
+        case 'j': o.jobs = max(1, atoi(optarg)); break;
+        case 'p': o.config.precision = o.config.global_precision = max(1, atoi(optarg)); break;
+        case 'a': o.config.angle_unit = static_cast<AngleUnit>(atoi(optarg)); break;
+        case 'm': o.config.parsing_mode = static_cast<ParsingMode>(atoi(optarg)); break;
+        case 't': o.timeout = max(1, atoi(optarg)); break;
+        case 'g': o.triggered = false; break;
+        case 'h': usage(argv[0], EXIT_SUCCESS);
+        default: usage(argv[0], EXIT_FAILURE);
+        }
+    if (optind < argc)
+        o.input = argv[optind];
+    return o;
+}
+
+string evaluate(Calculator &qalc, const Profiles &profiles, const Profile &profile,
+                const string &line, int timeout)
+{
+    MathStructure mstruct;
+    auto expression = qalc.unlocalizeExpression(line, profile.eo.parse_options);
+
+    if (!qalc.calculate(&mstruct, expression, timeout, profile.eo))
+    {
+        qalc.clearMessages();
+        return "error: timeout";
+    }
+
+    if (qalc.message())
+    {
+        string errors = "error: ";
+        for (auto msg = qalc.message(); msg; msg = qalc.nextMessage())
+        {
+            if (errors.size() > 7)
+                errors += ", ";
+            errors += msg->message();
+        }
+        return errors;
+    }
+
+    mstruct.format(profiles.po);
+    return mstruct.print(profiles.po);
+}
+
+void runWorker(Calculator &qalc, const Options &o, int in, int out)
+{
+    const auto profiles = Profiles::make(o.config);
+    const auto &profile = o.triggered ? profiles->triggered : profiles->global;
+    qalc.setPrecision(profile.precision);
+
+    FILE *fin = fdopen(in, "r");
+    FILE *fout = fdopen(out, "w");
+    char *line = nullptr;
+    size_t cap = 0;
+
+    for (ssize_t len; (len = getline(&line, &cap, fin)) != -1;)
+    {
+        string expression(line, len > 0 && line[len-1] == '\n' ? len - 1 : len);
+        auto result = evaluate(qalc, *profiles, profile, expression, o.timeout);
+        for (auto &c : result)
+            if (c == '\n')
+                c = ' ';
+        fputs(result.c_str(), fout);
+        fputc('\n', fout);
+        fflush(fout);
+    }
+
+    free(line);
+}
+
+vector<Worker> spawnWorkers(CalculatorTemplate &t, const Options &o)
+{
+    vector<Worker> workers;
+    for (int i = 0; i < o.jobs; ++i)
+    {
+        int to_worker[2], from_worker[2];
+        if (pipe(to_worker) || pipe(from_worker))
+        {
+            perror("pipe");
+            exit(EXIT_FAILURE);
+        }
+
+        pid_t pid = t.fork([&](Calculator &qalc){
+            for (auto &w : workers)
+            {
+                close(w.in);
+                close(w.out);
+            }
+            close(to_worker[1]);
+            close(from_worker[0]);
+            runWorker(qalc, o, to_worker[0], from_worker[1]);
+        });
+
+        if (pid < 0)
+        {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+
+        close(to_worker[0]);
+        close(from_worker[1]);
+        fcntl(to_worker[1], F_SETFL, O_NONBLOCK);
+        workers.push_back({pid, to_worker[1], from_worker[0], {}, {}, {}, {}});
+    }
+    return workers;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    const auto o = parseArgs(argc, argv);
+    signal(SIGPIPE, SIG_IGN);
+
+    int input = STDIN_FILENO;
+    if (o.input && (input = open(o.input, O_RDONLY)) < 0)
+    {
+        perror(o.input);
+        return EXIT_FAILURE;
+    }
+
+    const auto start = steady_clock::now();
+    CalculatorTemplate calculator_template;
+    const auto loaded = steady_clock::now();
+    auto workers = spawnWorkers(calculator_template, o);
+    const auto spawned = steady_clock::now();
+
+    // Bound the work in flight to keep memory flat for large inputs
+    const size_t window = 64 * workers.size();
+    map<size_t, string> done;
+    string inbuf;
+    size_t next_id = 0, next_out = 0, next_worker = 0;
+    bool eof = false;
+
+    auto dispatch = [&](string &&expression){
+        auto &w = workers[next_worker++ % workers.size()];
+        w.pending.push_back(next_id++);
+        w.outbuf += expression;
+        w.outbuf += '\n';
+    };
+
+    while (!eof || next_out < next_id)
+    {
+        vector<pollfd> fds;
+        const bool accept_input = !eof && next_id - next_out < window;
+        if (accept_input)
+            fds.push_back({input, POLLIN, 0});
+        for (auto &w : workers)
+        {
+            if (w.out >= 0)
+                fds.push_back({w.out, POLLIN, 0});
+            if (!w.outbuf.empty())
+                fds.push_back({w.in, POLLOUT, 0});
+        }
+
+        if (poll(fds.data(), fds.size(), -1) < 0)
+        {
+            perror("poll");
+            return EXIT_FAILURE;
+        }
+
+        for (const auto &p : fds)
+        {
+            if (!p.revents)
+                continue;
+
+            if (p.fd == input)
+            {
+                char buf[1 << 16];
+                auto n = read(input, buf, sizeof(buf));
+                if (n <= 0)
+                {
+                    eof = true;
+                    if (!inbuf.empty())
+                        dispatch(std::move(inbuf));
+                    for (auto &w : workers)
+                        if (w.outbuf.empty() && w.in >= 0)
+                            w.in = (close(w.in), -1);
+                    continue;
+                }
+                inbuf.append(buf, n);
+                for (size_t pos; (pos = inbuf.find('\n')) != string::npos;)
+                {
+                    dispatch(inbuf.substr(0, pos));
+                    inbuf.erase(0, pos + 1);
+                }
+                continue;
+            }
+
+            for (auto &w : workers)
+            {
+                if (p.fd == w.in)
+                {
+                    auto n = write(w.in, w.outbuf.data(), w.outbuf.size());
+                    if (n > 0)
+                        w.outbuf.erase(0, n);
+                    if (eof && w.outbuf.empty())
+                        w.in = (close(w.in), -1);
+                }
+                else if (p.fd == w.out)
+                {
+                    char buf[1 << 16];
+                    auto n = read(w.out, buf, sizeof(buf));
+                    if (n <= 0)
+                    {
+                        if (!w.pending.empty())
+                        {
+                            fprintf(stderr, "Worker %d terminated unexpectedly\n", w.pid);
+                            return EXIT_FAILURE;
+                        }
+                        w.out = (close(w.out), -1);
+                        continue;
+                    }
+                    // Sample once the worker touched its pages by evaluating
+                    if (w.memory.rss_kb == 0)
+                        w.memory = CalculatorTemplate::memoryUsage(w.pid);
+
+                    w.inbuf.append(buf, n);
+                    for (size_t pos; (pos = w.inbuf.find('\n')) != string::npos;)
+                    {
+                        done.emplace(w.pending.front(), w.inbuf.substr(0, pos));
+                        w.pending.pop_front();
+                        w.inbuf.erase(0, pos + 1);
+                    }
+                }
+            }
+        }
+
+        for (auto it = done.begin(); it != done.end() && it->first == next_out; it = done.erase(it))
+        {
+            fputs(it->second.c_str(), stdout);
+            fputc('\n', stdout);
+            ++next_out;
+        }
+        fflush(stdout);
+    }
+
+    for (auto &w : workers)
+    {
+        if (w.in >= 0)
+            close(w.in);
+        if (w.out >= 0)
+            close(w.out);
+        waitpid(w.pid, nullptr, 0);
+    }
+
+    const auto elapsed = duration<double>(steady_clock::now() - start).count();
+    fprintf(stderr, "%zu expressions in %.3f s (%.1f expressions/s) using %zu workers\n",
+            next_id, elapsed, elapsed > 0 ? next_id / elapsed : 0.0, workers.size());
+
+    CalculatorTemplate::MemoryUsage memory;
+    size_t sampled = 0;
+    for (const auto &w : workers)
+        if (w.memory.rss_kb)
+        {
+            memory.rss_kb += w.memory.rss_kb;
+            memory.pss_kb += w.memory.pss_kb;
+            memory.shared_kb += w.memory.shared_kb;
+            memory.private_kb += w.memory.private_kb;
+            ++sampled;
+        }
+
+    fprintf(stderr, "template loaded in %lld ms, workers forked in %.1f ms\n",
+            (long long)calculator_template.loadTimings().total().count(),
+            duration<double, milli>(spawned - loaded).count());
+    if (sampled)
+        fprintf(stderr, "worker memory (avg): rss %zu kB, pss %zu kB, shared %zu kB, private %zu kB\n",
+                memory.rss_kb / sampled, memory.pss_kb / sampled,
+                memory.shared_kb / sampled, memory.private_kb / sampled);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,254 @@
+// Copyright (c) 2026 Manuel Schneider
+//
+// Replays a query recording against the local socket of the plugin and reports latency,
+// wasted work and cache hit rate. Each query supersedes the previous one, like keystrokes
+// in the launcher do, and is scheduled on the lane of the handler that recorded it.
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+struct Query
+{
+    milliseconds offset;  // since replay start
+    bool global;
+    string expression;
+};
+
+struct Options
+{
+    string socket_path;
+    double speed = 1.0;
+    unsigned deadline_ms = 0;
+    const char *recording = nullptr;
+};
+
+[[noreturn]] void usage(const char *argv0, int status)
+{
+    fprintf(status ? stderr : stdout,
+            "Usage: %s [options] <recording>\n"
+            "\n"
+            "Replays a query recording against the calculator plugin socket.\n"
+            "\n"
+            "  -S <path>      Socket path (default: $XDG_RUNTIME_DIR/albert-calculator.sock)\n"
+            "  -s <factor>    Speed factor, 0 sends as fast as possible (default: 1)\n"
+            "  -d <ms>        Deadline per request, 0 for the global budget (default: 0)\n"
+            "  -h             Show this help\n",
+            argv0);
+    exit(status);
+}
+
+Options parseArgs(int argc, char **argv)
+{
+    Options o;
+    if (const char *dir = getenv("XDG_RUNTIME_DIR"))
+        o.socket_path = string(dir) + "/albert-calculator.sock";
+
+    for (int c; (c = getopt(argc, argv, "S:s:d:h")) != -1;)
+        switch (c)
+        {
+        case 'S': o.socket_path = optarg; break;
+        case 's': o.speed = max(0.0, atof(optarg)); break;
+        case 'd': o.deadline_ms = (unsigned)max(0, atoi(optarg)); break;
+        case 'h': usage(argv[0], EXIT_SUCCESS);
+        default: usage(argv[0], EXIT_FAILURE);
+        }
+
+    if (optind >= argc || o.socket_path.empty())
+        usage(argv[0], EXIT_FAILURE);
+    o.recording = argv[optind];
+    return o;
+}
+
+// Sessions are replayed back to back
+vector<Query> readRecording(const char *path, size_t &skipped)
+{
+    vector<Query> queries;
+    ifstream in(path);
+    string line;
+    milliseconds session_base{0}, last{0};
+
+    while (getline(in, line))
+    {
+        if (line.starts_with("# session"))
+        {
+            session_base = last;
+            continue;
+        }
+
+        auto t1 = line.find('\t');
+        auto t2 = t1 == string::npos ? t1 : line.find('\t', t1 + 1);
+        auto t3 = t2 == string::npos ? t2 : line.find('\t', t2 + 1);
+        if (t3 == string::npos || t3 != t2 + 2)
+            continue;
+
+        if (line[t2 + 1] == 'h')
+        {
+            ++skipped;
+            continue;
+        }
+
+        last = session_base + milliseconds(atoll(line.c_str()));
+        queries.push_back({last, line[t1 + 1] == 'g', line.substr(t3 + 1)});
+    }
+
+    return queries;
+}
+
+void writeAll(int fd, const string &data)
+{
+    for (size_t written = 0; written < data.size();)
+    {
+        auto n = write(fd, data.data() + written, data.size() - written);
+        if (n <= 0)
+        {
+            perror("write");
+            exit(EXIT_FAILURE);
+        }
+        written += n;
+    }
+}
+
+string frame(const Query &q, unsigned deadline_ms)
+{
+    string f(4 + 5, '\0');
+    const uint32_t len = htonl(5 + q.expression.size());
+    const uint32_t deadline = htonl(deadline_ms);
+    memcpy(f.data(), &len, 4);
+    f[4] = (q.global ? 1 : 0) | 2 | 4;  // supersede, launcher priority
+    memcpy(f.data() + 5, &deadline, 4);
+    return f + q.expression;
+}
+
+double percentile(vector<double> v, double p)
+{
+    if (v.empty())
+        return 0;
+    sort(v.begin(), v.end());
+    return v[min(v.size() - 1, (size_t)(p * (v.size() - 1) + 0.5))];
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    const auto o = parseArgs(argc, argv);
+
+    size_t skipped = 0;
+    const auto queries = readRecording(o.recording, skipped);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, o.socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+    {
+        perror(o.socket_path.c_str());
+        return EXIT_FAILURE;
+    }
+
+    deque<steady_clock::time_point> sent;
+    vector<double> latencies;  // completed requests
+    double wasted_ms = 0;
+    size_t errors = 0, aborted = 0, cache_hits = 0, next = 0, received = 0;
+    string buffer;
+
+    const auto start = steady_clock::now();
+    auto due = [&](size_t i){
+        return start + duration_cast<steady_clock::duration>(
+                           o.speed > 0 ? queries[i].offset / o.speed : milliseconds(0));
+    };
+
+    while (received < queries.size())
+    {
+        auto now = steady_clock::now();
+        for (; next < queries.size() && due(next) <= now; ++next)
+        {
+            writeAll(fd, frame(queries[next], o.deadline_ms));
+            sent.push_back(steady_clock::now());
+        }
+
+        int timeout = -1;
+        if (next < queries.size())
+            timeout = (int)max<long long>(0, duration_cast<milliseconds>(due(next) - now).count());
+
+        pollfd p{fd, POLLIN, 0};
+        if (poll(&p, 1, timeout) <= 0)
+            continue;
+
+        char buf[1 << 16];
+        auto n = read(fd, buf, sizeof(buf));
+        if (n <= 0)
+        {
+            fprintf(stderr, "Connection closed by server\n");
+            return EXIT_FAILURE;
+        }
+        buffer.append(buf, n);
+
+        while (buffer.size() >= 4)
+        {
+            uint32_t len;
+            memcpy(&len, buffer.data(), 4);
+            len = ntohl(len);
+            if (buffer.size() < 4 + len)
+                break;
+            if (len < 6)
+            {
+                fprintf(stderr, "Malformed response\n");
+                return EXIT_FAILURE;
+            }
+
+            const auto latency = duration<double, milli>(steady_clock::now() - sent.front()).count();
+            sent.pop_front();
+            ++received;
+
+            uint32_t calculate_us;
+            memcpy(&calculate_us, buffer.data() + 6, 4);
+            calculate_us = ntohl(calculate_us);
+
+            const auto status = buffer[4];
+            if (status == 2)
+            {
+                ++aborted;
+                wasted_ms += calculate_us / 1000.0;
+            }
+            else
+            {
+                latencies.push_back(latency);
+                errors += status == 1;
+                cache_hits += buffer[5] & 1;
+            }
+
+            buffer.erase(0, 4 + len);
+        }
+    }
+
+    const auto elapsed = duration<double>(steady_clock::now() - start).count();
+    const auto completed = latencies.size();
+
+    printf("queries:    %zu replayed in %.3f s, %zu hashed skipped\n", queries.size(), elapsed, skipped);
+    printf("completed:  %zu (%zu errors)\n", completed, errors);
+    printf("cancelled:  %zu, %.1f ms wasted\n", aborted, wasted_ms);
+    printf("cache hits: %zu (%.1f %%)\n", cache_hits, completed ? 100.0 * cache_hits / completed : 0.0);
+    printf("latency:    p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+           percentile(latencies, .5), percentile(latencies, .95), percentile(latencies, .99),
+           latencies.empty() ? 0.0 : *max_element(latencies.begin(), latencies.end()));
+
+    close(fd);
+    return EXIT_SUCCESS;
+}